@@ -0,0 +1,126 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <SDL2/SDL_mixer.h>
+#include <chrono>
+#include <future>
+#include <vector>
+
+#include "audio.h"
+#include "game_world.h"
+#include "resource_pack.h"
+
+//-------------------------------------------------------
+//                      GRASS BLADES
+//-------------------------------------------------------
+struct GrassBlade {
+    float x;
+    float y;
+    float height;
+    float waveOffset;
+    float randomAmplitude; // Varied amplitude for each blade
+};
+
+const int GRASS_BLADE_COUNT = 3000;
+
+// Scatter blades over the bottom half of the screen. Uses its own Rng so
+// it can run on any thread.
+inline std::vector<GrassBlade> generateGrassBlades(Uint64 seed) {
+    Rng rng;
+    rng.seed(seed);
+    std::vector<GrassBlade> blades;
+    blades.reserve(GRASS_BLADE_COUNT);
+    for (int i = 0; i < GRASS_BLADE_COUNT; ++i) {
+        GrassBlade blade;
+        blade.x               = static_cast<float>(rng.range(SCREEN_WIDTH));
+        // random bottom half
+        blade.y               = static_cast<float>(SCREEN_HEIGHT - rng.range(SCREEN_HEIGHT / 2));
+        blade.height          = 10.0f + static_cast<float>(rng.range(40));
+        blade.waveOffset      = static_cast<float>(rng.range(100)) * 0.1f;
+        blade.randomAmplitude = 0.5f + static_cast<float>(rng.range(10));
+        blades.push_back(blade);
+    }
+    return blades;
+}
+
+//-------------------------------------------------------
+//                     ASSET LOADING
+//-------------------------------------------------------
+// Everything the game loads from the resource pack or generates before
+// it looks finished. None of it touches the renderer, so it can be built
+// on a worker thread while the main thread is already drawing frames.
+// Sounds go straight into the AudioSystem passed to the loader.
+struct LoadedAssets {
+    TTF_Font*  font;
+    TTF_Font*  scoreFont;
+    bool       audioOpen;
+    std::vector<GrassBlade> grass;
+
+    // Time spent on each part, in milliseconds.
+    double audioMs;
+    double fontMs;
+    double soundMs;
+    double grassMs;
+};
+
+inline double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+inline LoadedAssets loadAssets(Uint64 grassSeed, AudioSystem* audio, AudioConfig audioConfig) {
+    LoadedAssets a;
+    auto start = std::chrono::steady_clock::now();
+    a.audioOpen = audio->open(audioConfig);
+    a.audioMs = millisSince(start);
+
+    start = std::chrono::steady_clock::now();
+    a.font      = TTF_OpenFontRW(resources().open("COMIC.TTF"), 1, 24);
+    a.scoreFont = TTF_OpenFontRW(resources().open("COMIC.TTF"), 1, 28);
+    a.fontMs = millisSince(start);
+
+    start = std::chrono::steady_clock::now();
+    audio->load(Sound::COLLISION, "colision.wav");
+    audio->load(Sound::EAT, "eat.wav");
+    a.soundMs = millisSince(start);
+
+    start = std::chrono::steady_clock::now();
+    a.grass = generateGrassBlades(grassSeed);
+    a.grassMs = millisSince(start);
+    return a;
+}
+
+// Runs loadAssets() on a background thread. The main thread polls once a
+// frame and takes the result when it is ready.
+class AssetLoader {
+public:
+    // audio must stay untouched by the caller until the result is taken.
+    void start(Uint64 grassSeed, AudioSystem* audio, const AudioConfig& audioConfig) {
+        pending = std::async(std::launch::async, loadAssets, grassSeed, audio, audioConfig);
+    }
+
+    bool loading() const { return pending.valid(); }
+
+    // True once, when the assets are ready to be taken.
+    bool poll(LoadedAssets& out) {
+        if (!pending.valid() ||
+            pending.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            return false;
+        }
+        out = pending.get();
+        return true;
+    }
+
+    // Block for the result; used on shutdown so nothing loaded is leaked.
+    bool finish(LoadedAssets& out) {
+        if (!pending.valid()) {
+            return false;
+        }
+        out = pending.get();
+        return true;
+    }
+
+private:
+    std::future<LoadedAssets> pending;
+};
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "resource_pack.h"
+#include "spsc_ring.h"
+
+//-------------------------------------------------------
+//                     AUDIO SETTINGS
+//-------------------------------------------------------
+// Samples per device buffer. A buffer has to be mixed in full before any of
+// it is heard, so this is the floor on sound latency: 512 samples is about
+// 12ms at 44.1kHz, where SDL_mixer's usual 2048 is 46ms.
+const int DEFAULT_AUDIO_BUFFER = 512;
+const int MIN_AUDIO_BUFFER     = 128;
+const int MAX_AUDIO_BUFFER     = 8192;
+
+const int AUDIO_FREQUENCY      = 44100;
+const int AUDIO_MIX_CHANNELS   = 16;
+
+// Leading samples quieter than this (about -54dBFS) are cut off effects at
+// load, so a sound starts on the tick that triggered it.
+const int AUDIO_SILENCE_LEVEL  = 64;
+
+// Play-to-mix latencies kept for reporting.
+const int AUDIO_LATENCY_SAMPLES = 1024;
+
+// Sound events waiting for the audio thread. Far more than a frame can
+// produce; when it is full, new events are dropped.
+const size_t AUDIO_EVENT_QUEUE = 256;
+
+// A repeat of a sound this soon after it last started is merged into it,
+// so a burst (several eats in one frame) plays once.
+const double AUDIO_COALESCE_MS = 30.0;
+
+// The audio thread wakes at least this often to check for shutdown.
+const Uint32 AUDIO_IDLE_WAIT_MS = 100;
+
+struct AudioConfig {
+    int frequency;
+    int bufferSamples;
+
+    AudioConfig()
+        : frequency(AUDIO_FREQUENCY),
+          bufferSamples(DEFAULT_AUDIO_BUFFER)
+    {
+    }
+};
+
+enum class Sound {
+    EAT,
+    COLLISION,
+    COUNT
+};
+
+// What the game asks for: a sound, where it comes from (-1 hard left to
+// 1 hard right) and when it was asked for.
+struct SoundEvent {
+    Sound  sound;
+    float  pan;
+    Uint64 postedAt;    // SDL_GetPerformanceCounter()
+};
+
+// Stereo position for a point on the screen.
+inline float panForX(float x, float width) {
+    return width > 0.0f ? std::max(-1.0f, std::min(1.0f, 2.0f * x / width - 1.0f)) : 0.0f;
+}
+
+//-------------------------------------------------------
+//                      AUDIO SYSTEM
+//-------------------------------------------------------
+// Owns the mixer device and the sound effects. Effects are decoded and
+// converted to the device's rate, format and channel count once, at load
+// (Mix_LoadWAV_RW does the conversion), and their leading silence is
+// trimmed, so playing one is just handing the mixer a ready buffer.
+//
+// The game thread never calls into SDL_mixer: post() puts the event on a
+// lock-free ring and wakes the audio thread, which does the panning,
+// merging and Mix_PlayChannel calls (and so takes the mixer's locks).
+//
+// Every event is timed from post() until the mixer first pulls samples
+// from it. Add one buffer's duration (bufferMs()) for the time until the
+// sound leaves the device.
+class AudioSystem {
+public:
+    AudioSystem()
+        : opened(false),
+          frequency(0),
+          format(0),
+          channels(0),
+          bufferSamples(0),
+          wake(nullptr),
+          running(false),
+          postedCount(0),
+          droppedCount(0),
+          playedCount(0),
+          mergedCount(0),
+          latencyCount(0)
+    {
+        for (auto& c : chunks) {
+            c = nullptr;
+        }
+        for (auto& t : playedAt) {
+            t = 0;
+        }
+        for (auto& t : trimmedMs) {
+            t = 0.0;
+        }
+        for (auto& t : lastStart) {
+            t = 0;
+        }
+    }
+
+    ~AudioSystem() {
+        close();
+    }
+
+    bool open(const AudioConfig& config) {
+        close();
+        bufferSamples = std::max(MIN_AUDIO_BUFFER, std::min(config.bufferSamples, MAX_AUDIO_BUFFER));
+        if (Mix_OpenAudio(config.frequency, MIX_DEFAULT_FORMAT, 2, bufferSamples) != 0) {
+            return false;
+        }
+        Mix_QuerySpec(&frequency, &format, &channels);
+        Mix_AllocateChannels(AUDIO_MIX_CHANNELS);
+        opened  = true;
+        wake    = SDL_CreateSemaphore(0);
+        running = true;
+        thread  = std::thread(&AudioSystem::run, this);
+        return true;
+    }
+
+    void close() {
+        if (!opened) {
+            return;
+        }
+        running = false;
+        SDL_SemPost(wake);
+        thread.join();
+        SDL_DestroySemaphore(wake);
+        wake = nullptr;
+        SoundEvent stale;
+        while (events.pop(stale)) {
+        }
+        Mix_HaltChannel(-1);
+        for (auto& c : chunks) {
+            if (c) {
+                Mix_FreeChunk(c);
+                c = nullptr;
+            }
+        }
+        Mix_CloseAudio();
+        opened = false;
+    }
+
+    bool isOpen() const { return opened; }
+
+    // Decode an effect from the resource pack into the device format.
+    bool load(Sound sound, const std::string& name) {
+        if (!opened) {
+            return false;
+        }
+        Mix_Chunk* chunk = Mix_LoadWAV_RW(resources().open(name), 1);
+        if (!chunk) {
+            return false;
+        }
+        trimmedMs[(int)sound] = trimSilence(chunk);
+        Mix_Chunk* old = chunks[(int)sound].exchange(chunk);
+        if (old) {
+            Mix_FreeChunk(old);
+        }
+        return true;
+    }
+
+    // Queue a sound; safe to call from one thread at a time (the game
+    // thread). Never blocks. Returns false if the event was dropped.
+    bool post(Sound sound, float pan = 0.0f) {
+        if (!opened) {
+            return false;
+        }
+        postedCount.fetch_add(1, std::memory_order_relaxed);
+        if (!events.push(SoundEvent{sound, pan, SDL_GetPerformanceCounter()})) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        SDL_SemPost(wake);
+        return true;
+    }
+
+    // Duration of one device buffer.
+    double bufferMs() const {
+        return frequency > 0 ? 1000.0 * bufferSamples / frequency : 0.0;
+    }
+
+    int buffer() const { return bufferSamples; }
+
+    // Silence cut from the front of an effect at load.
+    double trimmed(Sound sound) const { return trimmedMs[(int)sound]; }
+
+    // Event counts since the device was opened.
+    Uint64 posted() const  { return postedCount.load(); }
+    Uint64 dropped() const { return droppedCount.load(); }
+    Uint64 played() const  { return playedCount.load(); }
+    Uint64 merged() const  { return mergedCount.load(); }
+
+    // Post-to-mix latencies measured so far (the most recent
+    // AUDIO_LATENCY_SAMPLES), in milliseconds.
+    std::vector<double> latencies() const {
+        size_t n = std::min(latencyCount.load(), (size_t)AUDIO_LATENCY_SAMPLES);
+        return std::vector<double>(latencyMs, latencyMs + n);
+    }
+
+private:
+    bool       opened;
+    int        frequency;
+    Uint16     format;
+    int        channels;
+    int        bufferSamples;
+    std::atomic<Mix_Chunk*> chunks[(int)Sound::COUNT];
+    double     trimmedMs[(int)Sound::COUNT];
+
+    // Game thread -> audio thread.
+    SpscRing<SoundEvent, AUDIO_EVENT_QUEUE> events;
+    SDL_sem*           wake;
+    std::atomic<bool>  running;
+    std::thread        thread;
+    std::atomic<Uint64> postedCount;
+    std::atomic<Uint64> droppedCount;
+
+    // Audio thread only, apart from the counters.
+    Uint64              lastStart[(int)Sound::COUNT];
+    std::atomic<Uint64> playedCount;
+    std::atomic<Uint64> mergedCount;
+
+    // Written by the audio thread, consumed on the mixer thread.
+    std::atomic<Uint64> playedAt[AUDIO_MIX_CHANNELS];
+    std::atomic<size_t> latencyCount;
+    double              latencyMs[AUDIO_LATENCY_SAMPLES];
+
+    void run() {
+        const double ticksPerMs = (double)SDL_GetPerformanceFrequency() / 1000.0;
+        const Uint64 window = (Uint64)(AUDIO_COALESCE_MS * ticksPerMs);
+        while (running) {
+            SDL_SemWaitTimeout(wake, AUDIO_IDLE_WAIT_MS);
+            SoundEvent ev;
+            while (events.pop(ev)) {
+                Uint64& last = lastStart[(int)ev.sound];
+                if (last != 0 && ev.postedAt - last < window) {
+                    mergedCount.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                last = ev.postedAt;
+                start(ev);
+            }
+        }
+    }
+
+    void start(const SoundEvent& ev) {
+        Mix_Chunk* chunk = chunks[(int)ev.sound];
+        if (!chunk) {
+            return;
+        }
+        // Take a free channel ourselves so the panning and timing hooks
+        // are in place before the mixer can reach it; the mixer drops
+        // both when the sound ends.
+        int channel = -1;
+        for (int i = 0; i < AUDIO_MIX_CHANNELS; i++) {
+            if (!Mix_Playing(i)) {
+                channel = i;
+                break;
+            }
+        }
+        playedCount.fetch_add(1, std::memory_order_relaxed);
+        if (channel < 0) {
+            Mix_PlayChannel(-1, chunk, 0);
+            return;
+        }
+        // Full volume at the centre, fading the far side out towards the
+        // edges.
+        float left  = std::min(1.0f, 1.0f - ev.pan);
+        float right = std::min(1.0f, 1.0f + ev.pan);
+        Mix_SetPanning(channel, (Uint8)(255.0f * left), (Uint8)(255.0f * right));
+        playedAt[channel] = ev.postedAt;
+        Mix_RegisterEffect(channel, onMix, nullptr, this);
+        Mix_PlayChannel(channel, chunk, 0);
+    }
+
+    // Mixer-thread hook, run each time the channel is mixed.
+    static void onMix(int channel, void*, int, void* self) {
+        AudioSystem* a = static_cast<AudioSystem*>(self);
+        if (channel < 0 || channel >= AUDIO_MIX_CHANNELS) {
+            return;
+        }
+        Uint64 start = a->playedAt[channel].exchange(0);
+        if (start == 0) {
+            return;
+        }
+        size_t i = a->latencyCount.fetch_add(1) % AUDIO_LATENCY_SAMPLES;
+        a->latencyMs[i] = 1000.0 * (double)(SDL_GetPerformanceCounter() - start) /
+                          (double)SDL_GetPerformanceFrequency();
+    }
+
+    // Drop whole frames of near-silence from the start of a converted chunk.
+    // Only 16-bit formats are inspected. Returns the time removed.
+    double trimSilence(Mix_Chunk* chunk) const {
+        if (format != AUDIO_S16SYS || channels <= 0 || frequency <= 0) {
+            return 0.0;
+        }
+        const size_t frameBytes = 2 * channels;
+        const size_t frames = chunk->alen / frameBytes;
+        size_t first = 0;
+        for (; first < frames; first++) {
+            const Uint8* frame = chunk->abuf + first * frameBytes;
+            bool loud = false;
+            for (int c = 0; c < channels && !loud; c++) {
+                Sint16 s;
+                std::memcpy(&s, frame + 2 * c, 2);
+                loud = std::abs((int)s) > AUDIO_SILENCE_LEVEL;
+            }
+            if (loud) {
+                break;
+            }
+        }
+        if (first == 0 || first == frames) {
+            return 0.0;
+        }
+        const size_t cut = first * frameBytes;
+        std::memmove(chunk->abuf, chunk->abuf + cut, chunk->alen - cut);
+        chunk->alen -= (Uint32)cut;
+        return 1000.0 * first / frequency;
+    }
+};
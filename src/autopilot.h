@@ -0,0 +1,186 @@
+#pragma once
+
+#include "game_world.h"
+#include "distance_field.h"
+
+//-------------------------------------------------------
+//                      AUTOPILOT
+//-------------------------------------------------------
+// Steers the snake for unattended play. A distance field to all food is
+// kept in sync with the world incrementally, so the shortest-path step is
+// just the lowest of four neighbours. That step is only taken if the snake
+// could still reach its own tail afterwards (a breadth-first search over
+// the wrapping grid); otherwise it falls back to chasing its tail. All
+// buffers are sized once up front and reused, so choosing a move never
+// allocates.
+class Autopilot {
+public:
+    Autopilot()
+        : neighbours(GRID_COLS * GRID_ROWS * 4),
+          queue(GRID_COLS * GRID_ROWS),
+          distance(GRID_COLS * GRID_ROWS),
+          visited(GRID_COLS * GRID_ROWS, 0),
+          stamp(0),
+          field(GRID_COLS, GRID_ROWS),
+          fieldTicks(0),
+          fieldLayout(0),
+          fieldValid(false)
+    {
+        for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) {
+            for (int k = 0; k < 4; k++) {
+                neighbours[i * 4 + k] = neighbourCell(i, k);
+            }
+        }
+    }
+
+    // Pick the direction for the next tick of the given world.
+    Point chooseDirection(const GameWorld& world) {
+        if (world.snake.empty()) {
+            return world.direction;
+        }
+        const int head = cellIndex(world.snake.front());
+        const int tail = cellIndex(world.snake.back());
+        syncField(world);
+
+        // 1) Shortest path to the nearest food, if taking it is safe.
+        int down = field.downhill(head);
+        if (down >= 0) {
+            int first = neighbours[head * 4 + down];
+            if (isSafe(world, first, (world.cells[first] & CELL_FOOD) != 0)) {
+                return DIRECTIONS[down];
+            }
+        }
+
+        // 2) Otherwise follow the tail, picking the safe neighbour that is
+        //    farthest from it to leave the most room.
+        int bestDir   = -1;
+        int bestScore = -1;
+        for (int k = 0; k < 4; k++) {
+            int n = neighbours[head * 4 + k];
+            if (blocked(world, n, -1)) {
+                continue;
+            }
+            bool eats = (world.cells[n] & CELL_FOOD) != 0;
+            if (!isSafe(world, n, eats)) {
+                continue;
+            }
+            int reached = search(world, n, tail, freedTail(world, eats));
+            int d = (reached >= 0) ? distance[reached] : 0;
+            if (d > bestScore) {
+                bestScore = d;
+                bestDir   = k;
+            }
+        }
+        if (bestDir >= 0) {
+            return DIRECTIONS[bestDir];
+        }
+
+        // 3) No safe move: take any free cell and hope.
+        for (int k = 0; k < 4; k++) {
+            if (!blocked(world, neighbours[head * 4 + k], -1)) {
+                return DIRECTIONS[k];
+            }
+        }
+        return world.direction;
+    }
+
+private:
+    std::vector<int>    neighbours;  // 4 wrapped neighbours per cell
+    std::vector<int>    queue;       // BFS frontier
+    std::vector<int>    distance;    // BFS depth per cell
+    std::vector<Uint32> visited;     // cell is visited when == stamp
+    Uint32              stamp;
+
+    // Distance to the nearest food, and the world state it reflects.
+    DistanceField field;
+    Uint64        fieldTicks;
+    Uint32        fieldLayout;
+    bool          fieldValid;
+
+    // Bring the distance field up to date. A plain move only fills the new
+    // head and frees the old tail; anything else (food eaten, a reset, a
+    // skipped tick) rebuilds from scratch.
+    void syncField(const GameWorld& world) {
+        if (fieldValid && fieldLayout == world.layoutVersion) {
+            if (fieldTicks == world.ticks) {
+                return;
+            }
+            if (fieldTicks + 1 == world.ticks) {
+                field.setSolid(cellIndex(world.snake.front()), true);
+                if (world.lastFreedCell >= 0) {
+                    field.setSolid(world.lastFreedCell, false);
+                }
+                fieldTicks = world.ticks;
+                return;
+            }
+        }
+        field.clear();
+        for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) {
+            field.markSolid(i, (world.cells[i] & (CELL_SNAKE | CELL_OBSTACLE)) != 0);
+            field.markSource(i, (world.cells[i] & CELL_FOOD) != 0);
+        }
+        field.rebuild();
+        fieldTicks  = world.ticks;
+        fieldLayout = world.layoutVersion;
+        fieldValid  = true;
+    }
+
+    // The one body cell that stops being solid after the next move: the
+    // tail, unless the snake is eating and grows instead.
+    static int freedTail(const GameWorld& world, bool eats) {
+        return eats ? -1 : cellIndex(world.snake.back());
+    }
+
+    static bool blocked(const GameWorld& world, int cell, int freed) {
+        return cell != freed && (world.cells[cell] & (CELL_SNAKE | CELL_OBSTACLE));
+    }
+
+    // BFS from start to goal, which may itself be a body cell. Returns the
+    // reached cell or -1.
+    int search(const GameWorld& world, int start, int goal, int freed) {
+        if (++stamp == 0) {
+            // Stamp wrapped around: old marks could look current again.
+            std::fill(visited.begin(), visited.end(), 0);
+            stamp = 1;
+        }
+        int head = 0;
+        int tailPos = 0;
+        queue[tailPos++]  = start;
+        visited[start]    = stamp;
+        distance[start]   = 0;
+
+        while (head < tailPos) {
+            int cur = queue[head++];
+            for (int k = 0; k < 4; k++) {
+                int n = neighbours[cur * 4 + k];
+                if (visited[n] == stamp) {
+                    continue;
+                }
+                if (n == goal) {
+                    distance[n] = distance[cur] + 1;
+                    return n;
+                }
+                if (blocked(world, n, freed)) {
+                    continue;
+                }
+                visited[n]  = stamp;
+                distance[n] = distance[cur] + 1;
+                queue[tailPos++] = n;
+            }
+        }
+        return -1;
+    }
+
+    // After moving the head into cell next, can it still reach the tail?
+    // The old head becomes body, and the tail moves up one segment unless
+    // the snake grows.
+    bool isSafe(const GameWorld& world, int next, bool eats) {
+        const auto& snake = world.snake;
+        if (snake.size() < 2) {
+            return true;
+        }
+        int newTail = eats ? cellIndex(snake.back())
+                           : cellIndex(snake[snake.size() - 2]);
+        return search(world, next, newTail, freedTail(world, eats)) >= 0;
+    }
+};
@@ -0,0 +1,1452 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+
+#include "game_world.h"
+#include "assets.h"
+#include "audio.h"
+#include "autopilot.h"
+#include "canvas.h"
+#include "distance_field.h"
+#include "field_of_view.h"
+#include "hamiltonian.h"
+#include "light_map.h"
+#include "lookahead.h"
+#include "replay.h"
+#include "replay_analytics.h"
+#include "resource_pack.h"
+#include "rewind.h"
+#include "simulation.h"
+#include "snake_runs.h"
+#include "spsc_ring.h"
+#include "stats_store.h"
+#include "thread_pool.h"
+
+//-------------------------------------------------------
+//                   BENCHMARK HARNESS
+//-------------------------------------------------------
+// Headless micro-benchmarks, run with `--bench`. None of these open a
+// window or an audio device.
+
+typedef std::chrono::steady_clock BenchClock;
+
+inline double elapsedMicros(BenchClock::time_point start, BenchClock::time_point end) {
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+// Print mean / p50 / p99 / max of a set of samples in microseconds.
+inline void reportSamples(const std::string& name, std::vector<double>& samples) {
+    if (samples.empty()) {
+        std::cout << name << ": no samples\n";
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double s : samples) {
+        total += s;
+    }
+    std::cout << name
+              << ": n=" << samples.size()
+              << " mean=" << total / samples.size() << "us"
+              << " p50=" << samples[samples.size() / 2] << "us"
+              << " p99=" << samples[samples.size() * 99 / 100] << "us"
+              << " max=" << samples.back() << "us\n";
+}
+
+// The game tick as it was before GameWorld: one pass over plain vectors,
+// with every lookup a linear scan. Its randomness goes through the same
+// Rng in the same order, so with the same seed and directions it must
+// give exactly what GameWorld::step() gives.
+struct ReferenceWorld {
+    std::vector<Point> snake;
+    std::vector<Point> foodItems;
+    std::vector<Point> obstacles;
+    Point direction;
+    int   score;
+    int   numFoodItems;
+    int   numObstacles;
+    Rng   rng;
+
+    void reset() {
+        snake.clear();
+        snake.push_back({SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2});
+        direction = {1, 0};
+        score     = 0;
+        foodItems.clear();
+        obstacles.clear();
+        spawnFood();
+        spawnObstacles(numObstacles);
+    }
+
+    TickEvent step() {
+        Point newHead = {snake[0].x + direction.x * GRID_SIZE,
+                         snake[0].y + direction.y * GRID_SIZE};
+        if (newHead.x < 0) {
+            newHead.x = SCREEN_WIDTH - GRID_SIZE;
+        } else if (newHead.x >= SCREEN_WIDTH) {
+            newHead.x = 0;
+        }
+        if (newHead.y < 0) {
+            newHead.y = SCREEN_HEIGHT - GRID_SIZE;
+        } else if (newHead.y >= SCREEN_HEIGHT) {
+            newHead.y = 0;
+        }
+        if (std::find(snake.begin(), snake.end(), newHead) != snake.end()) {
+            return TickEvent::HIT_SELF;
+        }
+        if (std::find(obstacles.begin(), obstacles.end(), newHead) != obstacles.end()) {
+            return TickEvent::HIT_OBSTACLE;
+        }
+        snake.insert(snake.begin(), newHead);
+        if (std::find(foodItems.begin(), foodItems.end(), newHead) != foodItems.end()) {
+            score++;
+            foodItems.clear();
+            spawnFood();
+            spawnObstacles(5);
+            return TickEvent::ATE;
+        }
+        snake.pop_back();
+        return TickEvent::MOVED;
+    }
+
+    void spawnFood() {
+        for (int i = 0; i < numFoodItems; i++) {
+            Point food;
+            do {
+                food.x = rng.range(GRID_COLS) * GRID_SIZE;
+                food.y = rng.range(GRID_ROWS) * GRID_SIZE;
+            } while (std::find(snake.begin(), snake.end(), food) != snake.end() ||
+                     std::find(obstacles.begin(), obstacles.end(), food) != obstacles.end());
+            foodItems.push_back(food);
+        }
+    }
+
+    void spawnObstacles(int count) {
+        for (int i = 0; i < count; i++) {
+            Point obs;
+            do {
+                obs.x = rng.range(GRID_COLS) * GRID_SIZE;
+                obs.y = rng.range(GRID_ROWS) * GRID_SIZE;
+            } while (std::find(snake.begin(), snake.end(), obs) != snake.end() ||
+                     std::find(foodItems.begin(), foodItems.end(), obs) != foodItems.end());
+            obstacles.push_back(obs);
+        }
+    }
+};
+
+// Run GameWorld and ReferenceWorld side by side from the same seeds with
+// the same random turns, resetting both on every collision, and compare
+// the whole state and the RNG stream after each tick. Also times both.
+inline void benchTickDeterminism() {
+    const int seeds = 20;
+    const int ticks = 50000;
+    Uint64 compared = 0;
+    Uint64 games    = 0;
+    double worldUs  = 0.0;
+    double refUs    = 0.0;
+    std::string mismatch;
+    for (int s = 1; s <= seeds && mismatch.empty(); s++) {
+        GameWorld world;
+        ReferenceWorld ref;
+        world.seed((Uint64)s * 0x9E3779B97F4A7C15ull);
+        ref.rng = world.rng;
+        ref.numFoodItems = world.numFoodItems;
+        ref.numObstacles = world.numObstacles;
+        world.reset();
+        ref.reset();
+        Rng turns;
+        turns.seed((Uint64)s);
+        for (int t = 0; t < ticks; t++) {
+            if (turns.range(4) == 0) {
+                world.direction = DIRECTIONS[turns.range(4)];
+                ref.direction   = world.direction;
+            }
+            auto start = BenchClock::now();
+            TickEvent a = world.step();
+            auto mid = BenchClock::now();
+            TickEvent b = ref.step();
+            refUs   += elapsedMicros(mid, BenchClock::now());
+            worldUs += elapsedMicros(start, mid);
+            if (a == TickEvent::HIT_SELF || a == TickEvent::HIT_OBSTACLE) {
+                world.reset();
+                games++;
+            }
+            if (b == TickEvent::HIT_SELF || b == TickEvent::HIT_OBSTACLE) {
+                ref.reset();
+            }
+            compared++;
+            if (a != b || world.rng.state != ref.rng.state || world.score != ref.score ||
+                world.snake != ref.snake || world.foodItems != ref.foodItems ||
+                world.obstacles != ref.obstacles || !(world.direction == ref.direction)) {
+                mismatch = "seed " + std::to_string(s) + " tick " + std::to_string(t);
+                break;
+            }
+        }
+    }
+    std::cout << "tick determinism: " << compared << " ticks, " << games << " games, "
+              << (mismatch.empty() ? "identical to the reference tick"
+                                   : "MISMATCH at " + mismatch)
+              << "; step " << worldUs * 1000.0 / compared << "ns"
+              << " (reference " << refUs * 1000.0 / compared << "ns)\n";
+}
+
+// Time a bot's chooseDirection() over a long unattended session.
+template <typename Pilot>
+inline void benchPilot(const std::string& name) {
+    const int ticks = 20000;
+    GameWorld world;
+    Pilot pilot;
+    world.seed(1);
+    world.reset();
+
+    std::vector<double> samples;
+    samples.reserve(ticks);
+    int games = 1;
+    int best  = 0;
+    for (int t = 0; t < ticks; t++) {
+        auto start = BenchClock::now();
+        world.direction = pilot.chooseDirection(world);
+        samples.push_back(elapsedMicros(start, BenchClock::now()));
+
+        TickEvent ev = world.step();
+        best = std::max(best, world.score);
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            world.reset();
+            games++;
+        }
+    }
+    reportSamples(name + " decision", samples);
+    std::cout << "  games=" << games << " best score=" << best << "\n";
+}
+
+// Build a Hamiltonian tour over a board with 5% walls, then cut leaf
+// blocks one at a time the way obstacle spawns do.
+inline void benchHamiltonCycle(int width, int height) {
+    const int cellsTotal = width * height;
+    Rng rng;
+    rng.seed(777);
+    std::vector<Uint8> wall(cellsTotal, 0);
+    for (int i = 0; i < cellsTotal; i++) {
+        wall[i] = rng.range(20) == 0;
+    }
+
+    HamiltonCycle cycle(width, height);
+    auto start = BenchClock::now();
+    cycle.build(wall, 0);
+    double buildUs = elapsedMicros(start, BenchClock::now());
+
+    // Every tour step must move to an adjacent cell.
+    int broken = 0;
+    for (int c = 0; c < cellsTotal; c++) {
+        if (!cycle.contains(c)) {
+            continue;
+        }
+        int n = cycle.next(c);
+        int dx = std::abs(n % width - c % width);
+        int dy = std::abs(n / width - c / width);
+        dx = std::min(dx, width - dx);
+        dy = std::min(dy, height - dy);
+        if (dx + dy != 1) {
+            broken++;
+        }
+    }
+
+    int patched = 0;
+    int rebuilt = 0;
+    start = BenchClock::now();
+    for (int i = 0; i < 50; i++) {
+        int c = rng.range(cellsTotal);
+        wall[c] = 1;
+        if (cycle.removeCell(c)) {
+            patched++;
+        } else {
+            cycle.build(wall, 0);
+            rebuilt++;
+        }
+    }
+    double updateUs = elapsedMicros(start, BenchClock::now()) / 50;
+
+    std::cout << "hamiltonian " << width << "x" << height
+              << ": build=" << buildUs << "us"
+              << " tour=" << cycle.size() << "/" << cellsTotal << " cells"
+              << " update=" << updateUs << "us"
+              << " (" << patched << " patched, " << rebuilt << " rebuilt, "
+              << broken << " broken steps)\n";
+}
+
+// Compare incremental distance-field repair against full recomputation
+// while a 64-segment body wanders over a board with 10% walls.
+inline void benchDistanceField(int width, int height) {
+    const int cellsTotal = width * height;
+    Rng rng;
+    rng.seed(12345);
+
+    DistanceField field(width, height);
+    for (int i = 0; i < cellsTotal; i++) {
+        field.markSolid(i, rng.range(10) == 0);
+    }
+    int sources = std::max(10, cellsTotal / 4096);
+    for (int i = 0; i < sources; i++) {
+        int c = rng.range(cellsTotal);
+        field.markSource(c, true);
+    }
+
+    auto start = BenchClock::now();
+    const int rebuilds = (cellsTotal > 100000) ? 10 : 200;
+    for (int i = 0; i < rebuilds; i++) {
+        field.rebuild();
+    }
+    double rebuildUs = elapsedMicros(start, BenchClock::now()) / rebuilds;
+
+    const int ticks = 5000;
+    // Random walk: each tick fills the new head and frees the tail.
+    std::vector<int> body;
+    body.reserve(ticks);
+    int head = rng.range(cellsTotal);
+    while (field.isSolid(head)) {
+        head = rng.range(cellsTotal);
+    }
+    field.setSolid(head, true);
+    body.push_back(head);
+
+    int moved = 0;
+    start = BenchClock::now();
+    for (int t = 0; t < ticks; t++) {
+        int k = rng.range(4);
+        int next = -1;
+        for (int j = 0; j < 4 && next < 0; j++) {
+            int n = field.neighbour(head, (k + j) % 4);
+            if (!field.isSolid(n)) {
+                next = n;
+            }
+        }
+        if (next < 0) {
+            // Boxed in: lift the body and start again somewhere else.
+            for (int c : body) {
+                field.setSolid(c, false);
+            }
+            body.clear();
+            do {
+                next = rng.range(cellsTotal);
+            } while (field.isSolid(next));
+        }
+        field.setSolid(next, true);
+        body.insert(body.begin(), next);
+        head = next;
+        if (body.size() > 64) {
+            field.setSolid(body.back(), false);
+            body.pop_back();
+        }
+        moved++;
+    }
+    double incrementalUs = elapsedMicros(start, BenchClock::now()) / std::max(1, moved);
+
+    // Cross-check the repaired field against a fresh rebuild.
+    std::vector<int> repaired(cellsTotal);
+    for (int i = 0; i < cellsTotal; i++) {
+        repaired[i] = field.at(i);
+    }
+    field.rebuild();
+    int mismatches = 0;
+    for (int i = 0; i < cellsTotal; i++) {
+        if (!field.isSolid(i) && repaired[i] != field.at(i)) {
+            mismatches++;
+        }
+    }
+
+    std::cout << "distance field " << width << "x" << height
+              << ": full rebuild=" << rebuildUs << "us"
+              << " incremental tick=" << incrementalUs << "us"
+              << " (" << moved << " ticks, " << mismatches << " mismatches)\n";
+}
+
+// Search throughput of the lookahead bot, plus a check that a deep
+// step/undo round trip restores the world exactly.
+inline void benchLookahead() {
+    GameWorld world;
+    world.seed(3);
+    world.reset();
+    LookaheadPilot pilot;
+
+    const int ticks = 2000;
+    int games = 1;
+    int best  = 0;
+    auto start = BenchClock::now();
+    for (int t = 0; t < ticks; t++) {
+        world.direction = pilot.chooseDirection(world);
+        TickEvent ev = world.step();
+        best = std::max(best, world.score);
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            world.reset();
+            games++;
+        }
+    }
+    double us = elapsedMicros(start, BenchClock::now());
+
+    GameWorld copy;
+    copy.copyStateFrom(world);
+    world.recordUndo = true;
+    Rng dirs;
+    dirs.seed(9);
+    size_t mark = world.mark();
+    for (int i = 0; i < 500; i++) {
+        world.direction = DIRECTIONS[dirs.range(4)];
+        TickEvent ev = world.step();
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            break;
+        }
+    }
+    world.rewindTo(mark);
+    world.recordUndo = false;
+    bool same = world.snake == copy.snake && world.foodItems == copy.foodItems &&
+                world.obstacles == copy.obstacles && world.cells == copy.cells &&
+                world.score == copy.score && world.rng.state == copy.rng.state;
+
+    std::cout << "lookahead depth " << LookaheadPilot::DEFAULT_DEPTH
+              << ": " << pilot.nodeCount() / (us / 1e6) << " nodes/s"
+              << " (" << us / ticks << "us per decision)"
+              << " games=" << games << " best score=" << best
+              << " undo round trip " << (same ? "exact" : "MISMATCH") << "\n";
+}
+
+// Record an autopilot session, then check it plays back to the same final
+// state and time the recorder against bare step() calls and a live update().
+inline void benchReplay() {
+    const int ticks = 200000;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "csnake-bench.csr").string();
+
+    GameWorld world;
+    Autopilot pilot;
+    world.seed(42);
+    world.reset();
+    ReplayHeader header;
+    header.seed         = 42;
+    header.cols         = GRID_COLS;
+    header.rows         = GRID_ROWS;
+    header.numFoodItems = (Uint16)world.numFoodItems;
+    header.numObstacles = (Uint16)world.numObstacles;
+    header.gameMode     = 0;
+    header.snakeSpeed   = 100;
+    header.keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+
+    ReplayRecorder recorder;
+    if (!recorder.open(path, header)) {
+        std::cout << "replay: cannot write " << path << "\n";
+        return;
+    }
+    std::vector<Point> moves;
+    moves.reserve(ticks);
+    int games = 1;
+    double pilotUs = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        auto decided = BenchClock::now();
+        world.direction = pilot.chooseDirection(world);
+        pilotUs += elapsedMicros(decided, BenchClock::now());
+        moves.push_back(world.direction);
+        recorder.record(world);
+        TickEvent ev = world.step();
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            world.reset();
+            games++;
+        }
+    }
+    recorder.close();
+    size_t bytes = (size_t)std::filesystem::file_size(path);
+
+    // Play it back headlessly.
+    ReplayPlayer player;
+    GameWorld replayed;
+    player.load(path);
+    auto start = BenchClock::now();
+    player.start(replayed);
+    while (!player.finished()) {
+        TickEvent ev = player.advance(replayed);
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            replayed.reset();
+        }
+    }
+    double playUs = elapsedMicros(start, BenchClock::now());
+    bool same = replayed.snake == world.snake && replayed.foodItems == world.foodItems &&
+                replayed.cells == world.cells && replayed.score == world.score &&
+                replayed.rng.state == world.rng.state && player.position() == (Uint64)ticks;
+
+    // Recorder cost on the tick path: the same moves with and without it,
+    // best of a few runs each. Opening and closing the file happen once a
+    // session and are left out.
+    double timed[2] = {1e30, 1e30};
+    for (int run = 0; run < 10; run++) {
+        const int withRecorder = run % 2;
+        if (withRecorder) {
+            recorder.open(path, header);
+        }
+        GameWorld w;
+        w.seed(42);
+        w.reset();
+        start = BenchClock::now();
+        for (const Point& dir : moves) {
+            w.direction = dir;
+            recorder.record(w);
+            TickEvent ev = w.step();
+            if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+                w.reset();
+            }
+        }
+        timed[withRecorder] = std::min(timed[withRecorder], elapsedMicros(start, BenchClock::now()));
+        recorder.close();
+    }
+    std::filesystem::remove(path);
+    double recordNs = std::max(0.0, timed[1] - timed[0]) * 1000.0 / ticks;
+    double tickNs   = (timed[0] + pilotUs) * 1000.0 / ticks;
+
+    // The full update() of a live, recording game on its own thread, which
+    // is what the recorder is budgeted against.
+    const std::string dir =
+        (std::filesystem::temp_directory_path() / "csnake-bench-replays").string();
+    double updateNs;
+    {
+        Simulation sim;
+        sim.setReplayDir(dir);
+        sim.setUpdateTiming(true);
+        sim.start();
+        SessionConfig config = {1, 10, 15, 0, GameMode::NORMAL, PilotMode::CYCLE};
+        sim.send(SimCommand{SimCommandType::START_GAME, 0, {0, 0}, config, 0});
+        SDL_Delay(1500);
+        sim.stop();
+        updateNs = sim.meanUpdateMicros() * 1000.0;
+    }
+    std::filesystem::remove_all(dir);
+
+    std::cout << "replay: " << ticks << " ticks, " << games << " games in "
+              << bytes << " bytes (" << bytes * 8.0 / ticks << " bits/tick)"
+              << " playback=" << ticks / (playUs / 1e6) << " ticks/s"
+              << " record=" << recordNs << "ns/tick ("
+              << recordNs / (timed[0] * 1000.0 / ticks) * 100 << "% of step(), "
+              << recordNs / tickNs * 100 << "% of an autopilot tick, "
+              << recordNs / updateNs * 100 << "% of update() at " << updateNs << "ns)"
+              << " round trip " << (same ? "exact" : "MISMATCH") << "\n";
+}
+
+// A cheap stand-in player for very long recordings: keep going straight,
+// sometimes turn, and avoid walking into anything solid.
+inline Point wanderDirection(const GameWorld& world, Rng& rng) {
+    const int head = cellIndex(world.snake.front());
+    int first = (rng.range(8) == 0) ? rng.range(4) : directionCode(world.direction);
+    for (int j = 0; j < 4; j++) {
+        int k = (first + j) % 4;
+        if (!(world.cells[neighbourCell(head, k)] & (CELL_SNAKE | CELL_OBSTACLE))) {
+            return DIRECTIONS[k];
+        }
+    }
+    return world.direction;
+}
+
+// Seek latency on a 10M-tick recording, for a few keyframe spacings, and a
+// check that a seek lands on the same state as playing straight through.
+inline void benchReplaySeek() {
+    const Uint64 ticks = 10000000;
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "csnake-seek.csr").string();
+    const Uint32 intervals[] = {0, 65536, REPLAY_KEYFRAME_INTERVAL, 4096};
+
+    for (Uint32 interval : intervals) {
+        GameWorld world;
+        Rng moves;
+        moves.seed(5);
+        world.seed(5);
+        world.reset();
+        ReplayHeader header = {5, GRID_COLS, GRID_ROWS, (Uint16)world.numFoodItems,
+                               (Uint16)world.numObstacles, 0, 100, interval};
+        ReplayRecorder recorder;
+        if (!recorder.open(path, header)) {
+            std::cout << "replay seek: cannot write " << path << "\n";
+            return;
+        }
+        for (Uint64 t = 0; t < ticks; t++) {
+            world.direction = wanderDirection(world, moves);
+            recorder.record(world);
+            TickEvent ev = world.step();
+            if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+                world.reset();
+            }
+        }
+        recorder.close();
+        size_t bytes = (size_t)std::filesystem::file_size(path);
+
+        ReplayPlayer player;
+        player.load(path);
+        GameWorld replayed;
+
+        // Reference states from one straight playthrough.
+        const int checks = 8;
+        Uint64 checkTicks[checks];
+        std::vector<GameWorld> expected(checks);
+        Rng pick;
+        pick.seed(11);
+        for (int i = 0; i < checks; i++) {
+            checkTicks[i] = (ticks / checks) * i + pick.range(ticks / checks);
+        }
+        player.start(replayed);
+        for (int i = 0; i < checks; i++) {
+            player.seek(replayed, checkTicks[i]);
+            expected[i].copyStateFrom(replayed);
+        }
+
+        // Random seeks, some of them checked against the references.
+        const int seeks = (interval == 0) ? 10 : 200;
+        std::vector<double> samples;
+        int mismatches = 0;
+        for (int i = 0; i < seeks; i++) {
+            int c = pick.range(checks);
+            Uint64 target = (i % 4 == 0) ? checkTicks[c] : (Uint64)pick.range(ticks);
+            auto start = BenchClock::now();
+            player.seek(replayed, target);
+            samples.push_back(elapsedMicros(start, BenchClock::now()));
+            if (i % 4 == 0) {
+                const GameWorld& e = expected[c];
+                if (!(replayed.snake == e.snake && replayed.foodItems == e.foodItems &&
+                      replayed.obstacles == e.obstacles && replayed.cells == e.cells &&
+                      replayed.score == e.score && replayed.rng.state == e.rng.state)) {
+                    mismatches++;
+                }
+            }
+        }
+        std::cout << "replay seek, keyframe every " << interval << " ticks: "
+                  << bytes << " bytes, " << player.keyframeCount() << " keyframes, "
+                  << mismatches << " mismatches\n  ";
+        reportSamples("seek", samples);
+    }
+    std::filesystem::remove(path);
+}
+
+// Rewind with a 1000-segment snake: per-tick recording cost, including the
+// periodic trims, and how long it takes to go back 10,000 ticks.
+inline void benchRewind() {
+    const int length = 1000;
+    const size_t back = 10000;
+    GameWorld world;
+    world.numFoodItems = 0;
+    world.numObstacles = 0;
+    world.seed(1);
+    world.reset();
+
+    // Lay the body along a Hamiltonian tour and keep following it, so the
+    // snake never dies.
+    HamiltonCycle cycle(GRID_COLS, GRID_ROWS);
+    std::vector<Uint8> noWalls(GRID_COLS * GRID_ROWS, 0);
+    cycle.build(noWalls, 0);
+    std::fill(world.cells.begin(), world.cells.end(), 0);
+    world.snake.clear();
+    int c = 0;
+    for (int i = 0; i < length; i++) {
+        world.snake.insert(world.snake.begin(), cellPoint(c));
+        world.cells[c] |= CELL_SNAKE;
+        c = cycle.next(c);
+    }
+
+    RewindBuffer rewind(back);
+    rewind.start(world);
+    const int ticks = 50000;
+    std::vector<double> samples;
+    samples.reserve(ticks);
+    GameWorld snapshot;
+    for (int t = 0; t < ticks; t++) {
+        if (t == ticks - (int)back) {
+            snapshot.copyStateFrom(world);
+        }
+        int head = cellIndex(world.snake.front());
+        Point to = cellPoint(cycle.next(head));
+        int dx = to.x - world.snake.front().x;
+        int dy = to.y - world.snake.front().y;
+        world.direction = {(dx > 0) - (dx < 0), (dy > 0) - (dy < 0)};
+        if (std::abs(dx) > GRID_SIZE) {
+            world.direction.x = -world.direction.x;
+        }
+        if (std::abs(dy) > GRID_SIZE) {
+            world.direction.y = -world.direction.y;
+        }
+        auto start = BenchClock::now();
+        world.step();
+        rewind.afterStep(world);
+        samples.push_back(elapsedMicros(start, BenchClock::now()));
+    }
+    size_t memory = rewind.memoryUse(world);
+
+    auto start = BenchClock::now();
+    size_t went = rewind.rewind(world, back);
+    double rewindUs = elapsedMicros(start, BenchClock::now());
+    bool same = world.snake == snapshot.snake && world.cells == snapshot.cells &&
+                world.rng.state == snapshot.rng.state && world.score == snapshot.score;
+
+    reportSamples("rewind tick (1000 segments)", samples);
+    std::cout << "  rewind " << went << " ticks: " << rewindUs / 1000.0 << "ms, history "
+              << memory / 1024 << "KB, state " << (same ? "exact" : "MISMATCH") << "\n";
+}
+
+// Rewind history over many short games: each finished game is parked
+// with only the records it used, so however the ticks are split into
+// games the history stays within the live world's reservation plus as
+// much again parked (each up to a quarter over capacity), under three
+// times the capacity in undo records.
+inline void benchRewindShortGames() {
+    const size_t limit = DEFAULT_REWIND_TICKS;
+    GameWorld world;
+    world.seed(3);
+    world.reset();
+    RewindBuffer rewind(limit);
+    rewind.start(world);
+
+    // Random moves: the snake soon turns back into itself.
+    Rng rng;
+    rng.seed(3);
+    const int ticks = 30000;
+    int games = 1;
+    for (int t = 0; t < ticks; t++) {
+        world.direction = DIRECTIONS[rng.range(4)];
+        TickEvent ev = world.step();
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            rewind.beforeReset(world);
+            world.reset();
+            games++;
+        }
+        rewind.afterStep(world);
+    }
+    size_t memory = rewind.memoryUse(world);
+    size_t budget = limit * sizeof(UndoRecord);
+    size_t went   = rewind.rewind(world, rewind.available(world));
+
+    std::cout << "rewind over " << games << " games: history " << memory / 1024
+              << "KB for " << limit << " ticks (" << budget / 1024 << "KB of records, "
+              << (memory <= 3 * budget ? "ok" : "OVER") << "), rewound " << went
+              << " ticks\n";
+}
+
+// Invert one byte of a file in place.
+inline void flipByte(const std::string& path, long offset) {
+    FILE* f = std::fopen(path.c_str(), "r+b");
+    if (!f) {
+        return;
+    }
+    std::fseek(f, offset, SEEK_SET);
+    int c = std::fgetc(f);
+    std::fseek(f, offset, SEEK_SET);
+    std::fputc(c ^ 0xFF, f);
+    std::fclose(f);
+}
+
+// Stats store with a million games: how long record() holds the caller,
+// start-up with and without a summary, and recovery from a torn record, a
+// damaged one and a damaged header.
+inline void benchStatsStore() {
+    const int games = 1000000;
+    const std::string dir =
+        (std::filesystem::temp_directory_path() / "csnake-stats").string();
+    std::filesystem::remove_all(dir);
+
+    std::vector<double> samples;
+    samples.reserve(games);
+    double flushUs;
+    {
+        StatsStore store;
+        store.open(dir);
+        Rng rng;
+        rng.seed(8);
+        for (int i = 0; i < games; i++) {
+            GameRecord r = {(Uint64)i, 1700000000 + i, (Uint32)rng.range(200),
+                            (Uint32)rng.range(200), (Uint32)rng.range(100000),
+                            (Uint32)rng.range(1000000), (Uint8)rng.range(2), 0};
+            auto start = BenchClock::now();
+            store.record(r);
+            samples.push_back(elapsedMicros(start, BenchClock::now()));
+        }
+        auto start = BenchClock::now();
+        store.close();
+        flushUs = elapsedMicros(start, BenchClock::now());
+    }
+
+    auto start = BenchClock::now();
+    StatsStore reopened;
+    reopened.open(dir);
+    double loadUs = elapsedMicros(start, BenchClock::now());
+    StatsSummary expected = reopened.summary();
+    reopened.close();
+
+    std::filesystem::remove(dir + "/summary.bin");
+    start = BenchClock::now();
+    reopened.open(dir);
+    double scanUs = elapsedMicros(start, BenchClock::now());
+    bool sameTotals = reopened.summary().games == expected.games &&
+                      reopened.summary().totalScore == expected.totalScore &&
+                      reopened.summary().bestScore == expected.bestScore;
+    reopened.close();
+
+    // Tear the last record in half, as a crash mid-write would.
+    const std::string log = dir + "/games.log";
+    std::filesystem::resize_file(log, std::filesystem::file_size(log) - STATS_RECORD_SIZE / 2);
+    reopened.open(dir);
+    bool recovered = reopened.summary().games == (Uint64)games - 1 &&
+                     (std::filesystem::file_size(log) - STATS_LOG_HEADER_SIZE) % STATS_RECORD_SIZE == 0;
+    reopened.close();
+
+    // Flip a byte in a record mid-log: only that record is lost.
+    const size_t logSize = std::filesystem::file_size(log);
+    flipByte(log, STATS_LOG_HEADER_SIZE + (long)(games / 2) * STATS_RECORD_SIZE);
+    std::filesystem::remove(dir + "/summary.bin");
+    reopened.open(dir);
+    bool skipped = reopened.summary().games == (Uint64)games - 2 &&
+                   std::filesystem::file_size(log) == logSize;
+    reopened.close();
+
+    // Break the header: the old log is kept as games.log.bad.
+    flipByte(log, 0);
+    reopened.open(dir);
+    bool movedAside = reopened.summary().games == 0 &&
+                      std::filesystem::file_size(log + ".bad") == logSize;
+    reopened.close();
+    std::filesystem::remove_all(dir);
+
+    reportSamples("stats record() call", samples);
+    std::cout << "  " << games << " games: final flush=" << flushUs / 1000.0 << "ms"
+              << " load with summary=" << loadUs / 1000.0 << "ms"
+              << " full scan=" << scanUs / 1000.0 << "ms"
+              << (sameTotals ? "" : " TOTALS MISMATCH")
+              << " torn tail " << (recovered ? "recovered" : "NOT RECOVERED")
+              << ", bad record " << (skipped ? "skipped" : "NOT SKIPPED")
+              << ", bad header " << (movedAside ? "moved aside" : "NOT MOVED ASIDE") << "\n";
+}
+
+// Bulk analytics over a set of generated recordings: packet-level move
+// counting, and full event decoding, each spread over a thread pool.
+// Event-to-sound latency at a few device buffer sizes: play() to the first
+// mix of the effect, plus one buffer for the mixed audio to reach the
+// device. Needs a working audio device (SDL_AUDIODRIVER=dummy will do).
+inline void benchAudio() {
+    const int plays = 40;
+    for (int buffer : {2048, 512, 256}) {
+        AudioSystem audio;
+        AudioConfig config;
+        config.bufferSamples = buffer;
+        if (!audio.open(config) || !audio.load(Sound::EAT, "eat.wav")) {
+            std::cout << "audio: cannot open device or load eat.wav\n";
+            return;
+        }
+        audio.load(Sound::COLLISION, "colision.wav");
+        Rng rng;
+        rng.seed(buffer);
+        std::vector<double> postUs;
+        for (int i = 0; i < plays; i++) {
+            auto start = BenchClock::now();
+            audio.post(i % 4 == 3 ? Sound::COLLISION : Sound::EAT,
+                       (float)rng.range(201) / 100.0f - 1.0f);
+            postUs.push_back(elapsedMicros(start, BenchClock::now()));
+            SDL_Delay((Uint32)AUDIO_COALESCE_MS + (Uint32)rng.range(20));
+        }
+        // A burst, as when several food items are eaten in one frame.
+        for (int i = 0; i < 16; i++) {
+            audio.post(Sound::EAT);
+        }
+        SDL_Delay(100);
+        std::vector<double> ms = audio.latencies();
+        Uint64 played = audio.played();
+        Uint64 merged = audio.merged();
+        audio.close();
+
+        std::vector<double> samples;
+        for (double m : ms) {
+            samples.push_back(m * 1000.0);
+        }
+        reportSamples("audio post-to-mix, " + std::to_string(buffer) + " samples", samples);
+        std::cout << "  + buffer " << audio.bufferMs() << "ms to the device;"
+                  << " trimmed lead-in eat=" << audio.trimmed(Sound::EAT) << "ms"
+                  << " collision=" << audio.trimmed(Sound::COLLISION) << "ms;"
+                  << " played=" << played << " merged=" << merged << "\n";
+        reportSamples("  post() on the game thread", postUs);
+    }
+}
+
+// Tick timing on the simulation thread while the "render" thread takes
+// far longer per frame than a tick: updates should keep their pace (one
+// snapshot each; crashes do not advance world ticks, so those are not
+// counted), and every frame should find a fresh snapshot.
+inline void benchSimulationThread() {
+    const int    snakeSpeed = 5;
+    const Uint32 runMs      = 2000;
+    const Uint32 frameMs    = 40;
+    Simulation sim;
+    sim.setReplayDir("");
+    sim.start();
+    SessionConfig config = {snakeSpeed, 10, 15, 0, GameMode::NORMAL, PilotMode::CYCLE};
+    sim.send(SimCommand{SimCommandType::START_GAME, 0, {0, 0}, config, 0});
+
+    Uint32 start = SDL_GetTicks();
+    int frames = 0;
+    int fresh  = 0;
+    Uint64 first = 0;
+    while (SDL_GetTicks() - start < runMs) {
+        SDL_Delay(frameMs);
+        if (sim.refresh()) {
+            fresh++;
+            if (first == 0) {
+                first = sim.snapshot().sequence;
+            }
+        }
+        frames++;
+    }
+    Uint64 updates = sim.snapshot().sequence - first;
+    sim.stop();
+    std::cout << "simulation thread: " << updates << " updates in " << runMs << "ms at "
+              << snakeSpeed << "ms/tick (ideal " << runMs / snakeSpeed << ")"
+              << " with " << frameMs << "ms frames; " << fresh << "/" << frames
+              << " frames got a new snapshot\n";
+}
+
+// Key-to-move latency through the turn queue: random presses, some in
+// quick pairs inside one tick, against a live game on its own thread.
+inline void benchInputLatency() {
+    const int snakeSpeed = 50;
+    const int presses    = 200;
+    Simulation sim;
+    sim.setReplayDir("");
+    sim.start();
+    SessionConfig config = {snakeSpeed, 10, 0, 0, GameMode::NORMAL, PilotMode::OFF};
+    sim.send(SimCommand{SimCommandType::START_GAME, 0, {0, 0}, config, 0});
+
+    Rng rng;
+    rng.seed(41);
+    for (int i = 0; i < presses; i++) {
+        Point d = DIRECTIONS[rng.range(4)];
+        sim.send(SimCommand{SimCommandType::TURN, 0, d, config, SDL_GetPerformanceCounter()});
+        if (i % 4 == 0) {
+            // A second press a few ms later: the other axis.
+            SDL_Delay(3);
+            Point e = d.x != 0 ? DIRECTIONS[2 + rng.range(2)] : DIRECTIONS[rng.range(2)];
+            sim.send(SimCommand{SimCommandType::TURN, 0, e, config, SDL_GetPerformanceCounter()});
+        }
+        SDL_Delay((Uint32)rng.range(2 * snakeSpeed));
+    }
+    SDL_Delay(4 * snakeSpeed);
+    sim.stop();
+
+    const TurnQueue& input = sim.input();
+    std::vector<double> samples;
+    for (double ms : input.latencies()) {
+        samples.push_back(ms * 1000.0);
+    }
+    reportSamples("input-to-move at " + std::to_string(snakeSpeed) + "ms/tick", samples);
+    std::cout << "  turns queued=" << input.queuedCount() << " applied=" << input.appliedCount()
+              << " dropped=" << input.droppedCount() << "\n";
+}
+
+// Throughput of the lock-free ring between two threads.
+inline void benchSpscRing() {
+    const Uint64 items = 50000000;
+    static SpscRing<Uint64, 1024> ring;
+    auto start = BenchClock::now();
+    Uint64 sum = 0;
+    std::thread consumer([&sum, items] {
+        Uint64 v;
+        for (Uint64 got = 0; got < items;) {
+            if (ring.pop(v)) {
+                sum += v;
+                got++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (Uint64 i = 0; i < items;) {
+        if (ring.push(i)) {
+            i++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    double us = elapsedMicros(start, BenchClock::now());
+    std::cout << "spsc ring: " << items / us << "M items/s"
+              << (sum == items * (items - 1) / 2 ? "" : " CHECKSUM MISMATCH") << "\n";
+}
+
+// One busy game frame: grass, grid, the translucent overlay, a long snake
+// with food and obstacles, and flashlight fog around its head. Drawn at
+// width x height by scaling the 800x600 layout.
+inline void drawBenchFrame(Canvas& canvas, const std::vector<GrassBlade>& grass, float t,
+                           int width, int height) {
+    const float sx = (float)width / SCREEN_WIDTH;
+    const float sy = (float)height / SCREEN_HEIGHT;
+    auto cell = [sx, sy](int x, int y) {
+        return SDL_Rect{(int)(x * sx), (int)(y * sy),
+                        (int)((x + GRID_SIZE) * sx) - (int)(x * sx),
+                        (int)((y + GRID_SIZE) * sy) - (int)(y * sy)};
+    };
+    canvas.setBlendMode(SDL_BLENDMODE_NONE);
+    canvas.setColor(0, 0, 0, 255);
+    canvas.clear();
+    canvas.setColor(34, 139, 34, 255);
+    for (const GrassBlade& b : grass) {
+        float tipX = b.x + std::sin(t + b.waveOffset) * 1.5f * b.randomAmplitude;
+        canvas.drawLine((int)(b.x * sx), (int)(b.y * sy),
+                        (int)(tipX * sx), (int)((b.y - b.height) * sy));
+    }
+    canvas.setColor(50, 50, 50, 255);
+    for (int x = 0; x < SCREEN_WIDTH; x += GRID_SIZE) {
+        canvas.drawLine((int)(x * sx), 0, (int)(x * sx), height);
+    }
+    for (int y = 0; y < SCREEN_HEIGHT; y += GRID_SIZE) {
+        canvas.drawLine(0, (int)(y * sy), width, (int)(y * sy));
+    }
+    canvas.setBlendMode(SDL_BLENDMODE_BLEND);
+    canvas.setColor(30, 30, 30, 128);
+    canvas.fillRect(SDL_Rect{0, 0, width, height});
+    canvas.setColor(0, 255, 0, 255);
+    for (int i = 0; i < 200; i++) {
+        canvas.fillRect(cell((i % GRID_COLS) * GRID_SIZE, (5 + i / GRID_COLS) * GRID_SIZE));
+    }
+    const int headX = SCREEN_WIDTH / 2;
+    const int headY = SCREEN_HEIGHT / 2;
+    const int radius = 5 * GRID_SIZE;
+    for (int y = 0; y < SCREEN_HEIGHT; y += GRID_SIZE) {
+        for (int x = 0; x < SCREEN_WIDTH; x += GRID_SIZE) {
+            int dx = x + GRID_SIZE / 2 - headX;
+            int dy = y + GRID_SIZE / 2 - headY;
+            int d = dx * dx + dy * dy;
+            if (d > radius * radius) {
+                canvas.setColor(0, 0, 0, 255);
+            } else if (d > (radius - GRID_SIZE) * (radius - GRID_SIZE)) {
+                canvas.setColor(0, 0, 0, 170);
+            } else {
+                continue;
+            }
+            canvas.fillRect(cell(x, y));
+        }
+    }
+    canvas.present();
+}
+
+// Mean time per frame drawn through a Canvas on an off-screen SDL software
+// renderer, or a negative value if the backend is not available.
+inline double timeBenchFrames(RenderBackend backend, unsigned threads, int width, int height,
+                              const std::vector<GrassBlade>& grass) {
+    const int frames = 100;
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, width, height, 32,
+                                                         SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* renderer = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    double us = -1.0;
+    if (renderer) {
+        Canvas canvas;
+        if (canvas.init(renderer, width, height, backend) == backend) {
+            canvas.setRasterThreads(threads);
+            drawBenchFrame(canvas, grass, 0.0f, width, height);    // warm up
+            auto start = BenchClock::now();
+            for (int i = 0; i < frames; i++) {
+                drawBenchFrame(canvas, grass, i * 0.05f, width, height);
+            }
+            us = elapsedMicros(start, BenchClock::now()) / frames;
+        }
+    }
+    if (renderer) {
+        SDL_DestroyRenderer(renderer);
+    }
+    if (target) {
+        SDL_FreeSurface(target);
+    }
+    return us;
+}
+
+// The same frame through SDL's software renderer and through our own
+// rasterizer, at the window's size and at 4K, and how the tiled
+// rasterizer scales with threads.
+inline void benchRasterizer() {
+    std::vector<GrassBlade> grass = generateGrassBlades(12345);
+    const int sizes[][2] = {{SCREEN_WIDTH, SCREEN_HEIGHT}, {3840, 2160}};
+    const unsigned threadCounts[] = {1, 2, 4, 8, 16};
+    for (const auto& size : sizes) {
+        std::string res = std::to_string(size[0]) + "x" + std::to_string(size[1]);
+        double sdl = timeBenchFrames(RenderBackend::SDL, 1, size[0], size[1], grass);
+        if (sdl < 0.0) {
+            std::cout << "rasterizer " << res << ": no software renderer (" << SDL_GetError() << ")\n";
+            return;
+        }
+        std::cout << "rasterizer " << res << ": sdl backend " << sdl / 1000.0 << "ms/frame\n";
+        double single = 0.0;
+        for (unsigned threads : threadCounts) {
+            double us = timeBenchFrames(RenderBackend::SOFTWARE, threads, size[0], size[1], grass);
+            if (us < 0.0) {
+                std::cout << "rasterizer " << res << ": software backend unavailable\n";
+                break;
+            }
+            if (threads == 1) {
+                single = us;
+            }
+            std::cout << "rasterizer " << res << ": software backend x" << threads << " "
+                      << us / 1000.0 << "ms/frame (speedup " << single / us << ")\n";
+        }
+    }
+}
+
+// A snake filling all but one cell of the board, following a Hamiltonian
+// tour: the per-tick cost of keeping its runs, how many rectangles it
+// takes to draw, and whether they cover exactly the snake's cells.
+inline void benchSnakeRuns() {
+    GameWorld world;
+    world.numFoodItems = 0;
+    world.numObstacles = 0;
+    world.seed(1);
+    world.reset();
+
+    HamiltonCycle cycle(GRID_COLS, GRID_ROWS);
+    std::vector<Uint8> noWalls(GRID_COLS * GRID_ROWS, 0);
+    cycle.build(noWalls, 0);
+    std::fill(world.cells.begin(), world.cells.end(), 0);
+    world.snake.clear();
+    int c = 0;
+    for (int i = 0; i < GRID_COLS * GRID_ROWS - 1; i++) {
+        world.snake.insert(world.snake.begin(), cellPoint(c));
+        world.cells[c] |= CELL_SNAKE;
+        c = cycle.next(c);
+    }
+
+    SnakeRuns runs;
+    runs.sync(world.snake);
+    const int ticks = 20000;
+    std::vector<double> samples;
+    samples.reserve(ticks);
+    std::vector<SDL_Rect> rects;
+    std::vector<Uint8> covered(GRID_COLS * GRID_ROWS);
+    size_t most = 0;
+    bool exact = true;
+    for (int t = 0; t < ticks; t++) {
+        int head = cellIndex(world.snake.front());
+        Point to = cellPoint(cycle.next(head));
+        int dx = to.x - world.snake.front().x;
+        int dy = to.y - world.snake.front().y;
+        world.direction = {(dx > 0) - (dx < 0), (dy > 0) - (dy < 0)};
+        if (std::abs(dx) > GRID_SIZE) {
+            world.direction.x = -world.direction.x;
+        }
+        if (std::abs(dy) > GRID_SIZE) {
+            world.direction.y = -world.direction.y;
+        }
+        world.step();
+        auto start = BenchClock::now();
+        runs.sync(world.snake);
+        samples.push_back(elapsedMicros(start, BenchClock::now()));
+        most = std::max(most, runs.runCount());
+
+        if (t % 97 == 0) {
+            runs.rects(rects);
+            std::fill(covered.begin(), covered.end(), 0);
+            for (const SDL_Rect& r : rects) {
+                for (int y = r.y; y < r.y + r.h; y += GRID_SIZE) {
+                    for (int x = r.x; x < r.x + r.w; x += GRID_SIZE) {
+                        covered[cellIndex({x, y})]++;
+                    }
+                }
+            }
+            for (size_t i = 0; i < covered.size(); i++) {
+                exact = exact && covered[i] == ((world.cells[i] & CELL_SNAKE) ? 1 : 0);
+            }
+        }
+    }
+    reportSamples("snake runs sync (" + std::to_string(world.snake.size()) + " segments)", samples);
+    std::cout << "  at most " << most << " rects for " << world.snake.size()
+              << " cells, coverage " << (exact ? "exact" : "MISMATCH") << "\n";
+}
+
+// Shadowcasting from a wandering origin on a board with 5% walls: a full
+// recast per move, then single walls toggled near a still origin, which
+// recast only the octants holding them. Each incremental result is checked
+// against a fresh view.
+inline void benchFieldOfView(int width, int height, int radius) {
+    Rng rng;
+    rng.seed(48);
+    std::vector<Uint8> wall(width * height, 0);
+    FieldOfView fov(width, height);
+    for (int i = 0; i < width * height / 20; i++) {
+        int cell = rng.range(width * height);
+        if (!wall[cell]) {
+            wall[cell] = 1;
+            fov.addWall(cell);
+        }
+    }
+
+    const int moves = 20000;
+    std::vector<double> samples;
+    samples.reserve(moves);
+    int origin = (height / 2) * width + width / 2;
+    for (int t = 0; t < moves; t++) {
+        int x = (origin % width + DIRECTIONS[rng.range(4)].x + width) % width;
+        int y = (origin / width + DIRECTIONS[rng.range(4)].y + height) % height;
+        origin = y * width + x;
+        auto start = BenchClock::now();
+        fov.update(origin, radius);
+        samples.push_back(elapsedMicros(start, BenchClock::now()));
+    }
+    std::string board = std::to_string(width) + "x" + std::to_string(height) +
+                        " r=" + std::to_string(radius);
+    reportSamples("fov full recast " + board, samples);
+
+    const int toggles = 2000;
+    samples.clear();
+    Uint64 before = fov.octantsRecomputed();
+    bool exact = true;
+    for (int t = 0; t < toggles; t++) {
+        int dx = rng.range(2 * radius + 1) - radius;
+        int dy = rng.range(2 * radius + 1) - radius;
+        int x = std::min(std::max(origin % width + dx, 0), width - 1);
+        int y = std::min(std::max(origin / width + dy, 0), height - 1);
+        int cell = y * width + x;
+        auto start = BenchClock::now();
+        wall[cell] ^= 1;
+        if (wall[cell]) {
+            fov.addWall(cell);
+        } else {
+            fov.removeWall(cell);
+        }
+        fov.update(origin, radius);
+        samples.push_back(elapsedMicros(start, BenchClock::now()));
+
+        if (t % 50 == 0) {
+            FieldOfView fresh(width, height);
+            for (int c = 0; c < width * height; c++) {
+                if (wall[c]) {
+                    fresh.addWall(c);
+                }
+            }
+            fresh.update(origin, radius);
+            exact = exact && fresh.visibility() == fov.visibility();
+        }
+    }
+    reportSamples("fov wall toggle " + board, samples);
+    std::cout << "  " << (double)(fov.octantsRecomputed() - before) / toggles
+              << " octants recast per toggle, " << (exact ? "matches" : "MISMATCH")
+              << " a fresh view\n";
+}
+
+// A light map rebuilt from scratch with a head light and `count` food and
+// obstacle glows scattered over the board, as on every tick in the light
+// modes, checked against a plain per-cell sum over all lights.
+inline void benchLightMap(int width, int height, int count) {
+    Rng rng;
+    rng.seed(49);
+    std::vector<Light> lights;
+    lights.push_back(Light{width / 2, height / 2, FLASHLIGHT_RADIUS_BLOCKS + 0.5f, 1.6f});
+    for (int i = 0; i < count; i++) {
+        Light l = (i % 2) ? FOOD_LIGHT : OBSTACLE_LIGHT;
+        l.x = rng.range(width);
+        l.y = rng.range(height);
+        lights.push_back(l);
+    }
+
+    LightMap map(width, height);
+    const int rounds = 2000;
+    std::vector<double> samples;
+    samples.reserve(rounds);
+    for (int r = 0; r < rounds; r++) {
+        auto start = BenchClock::now();
+        map.clear();
+        for (const Light& l : lights) {
+            map.add(l);
+        }
+        map.finish();
+        samples.push_back(elapsedMicros(start, BenchClock::now()));
+    }
+    reportSamples("light map " + std::to_string(width) + "x" + std::to_string(height) + ", " +
+                  std::to_string(lights.size()) + " lights", samples);
+
+    int worst = 0;
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            float sum = 0.0f;
+            for (const Light& l : lights) {
+                float d2 = (float)((x - l.x) * (x - l.x) + (y - l.y) * (y - l.y));
+                sum += std::max(0.0f, l.intensity * (1.0f - d2 / (l.radius * l.radius)));
+            }
+            int want = (int)(std::min(sum, 1.0f) * 255.0f + 0.5f);
+            worst = std::max(worst, std::abs(want - (int)map.levels()[y * width + x]));
+        }
+    }
+    std::cout << "  largest difference from a plain sum: " << worst << " levels\n";
+}
+
+// Cold unpack of every packed asset, including the checksum test.
+inline void benchResourcePack() {
+    ResourcePack pack;
+    if (!pack.embedded()) {
+        std::cout << "resource pack: not built in (run tools/pack_resources.py)\n";
+        return;
+    }
+    for (const std::string& name : pack.names()) {
+        auto start = BenchClock::now();
+        SDL_RWops* rw = pack.open(name);
+        double us = elapsedMicros(start, BenchClock::now());
+        std::cout << "resource pack " << name << ": unpack=" << us / 1000.0 << "ms"
+                  << (rw ? "" : " FAILED") << "\n";
+        if (rw) {
+            SDL_RWclose(rw);
+        }
+    }
+}
+
+inline void benchReplayAnalytics() {
+    const int files = 32;
+    const Uint64 ticksPerFile = 500000;
+    const auto dir = std::filesystem::temp_directory_path() / "csnake-analytics";
+    std::filesystem::create_directories(dir);
+
+    std::vector<std::string> paths;
+    for (int f = 0; f < files; f++) {
+        paths.push_back((dir / ("bench-" + std::to_string(f) + ".csr")).string());
+        GameWorld world;
+        Rng moves;
+        moves.seed(100 + f);
+        world.seed(100 + f);
+        world.reset();
+        ReplayHeader header = {(Uint64)(100 + f), GRID_COLS, GRID_ROWS, (Uint16)world.numFoodItems,
+                               (Uint16)world.numObstacles, 0, 100, REPLAY_KEYFRAME_INTERVAL};
+        ReplayRecorder recorder;
+        recorder.open(paths.back(), header);
+        for (Uint64 t = 0; t < ticksPerFile; t++) {
+            world.direction = wanderDirection(world, moves);
+            recorder.record(world);
+            TickEvent ev = world.step();
+            if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+                world.reset();
+            }
+        }
+    }
+
+    ThreadPool pool;
+    ThreadPool single(1);
+
+    const int passes = 50;
+    ReplayMoveStats moves = {0, 0, 0, {0, 0, 0, 0}};
+    auto start = BenchClock::now();
+    for (int i = 0; i < passes; i++) {
+        moves = countReplayMoves(paths, pool);
+    }
+    double countUs = elapsedMicros(start, BenchClock::now()) / passes;
+
+    start = BenchClock::now();
+    ReplayStats one = analyzeReplays(paths, single);
+    double singleUs = elapsedMicros(start, BenchClock::now());
+    start = BenchClock::now();
+    ReplayStats all = analyzeReplays(paths, pool);
+    double poolUs = elapsedMicros(start, BenchClock::now());
+
+    std::filesystem::remove_all(dir);
+
+    bool agree = moves.moves == all.ticks && one.ticks == all.ticks &&
+                 one.games == all.games && one.scores == all.scores;
+    std::cout << "replay analytics: " << files << " files, " << all.bytes << " bytes, "
+              << all.ticks << " ticks, " << all.games << " games, "
+              << pool.size() << " threads\n"
+              << "  move count: " << moves.bytes / countUs / 1000.0 << " GB/s\n"
+              << "  event decode: 1 thread " << one.ticks / singleUs << "M ticks/s ("
+              << one.bytes / singleUs << " MB/s), pool " << all.ticks / poolUs << "M ticks/s ("
+              << all.bytes / poolUs << " MB/s)"
+              << (agree ? "" : " MISMATCH") << "\n";
+}
+
+// `--analyze <file|dir>...`: score distribution and death causes over a
+// set of recordings.
+inline int runAnalyze(const std::vector<std::string>& args) {
+    std::vector<std::string> paths;
+    for (const auto& arg : args) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(arg, ec)) {
+            for (const auto& entry : std::filesystem::directory_iterator(arg, ec)) {
+                if (entry.path().extension() == ".csr") {
+                    paths.push_back(entry.path().string());
+                }
+            }
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    ThreadPool pool;
+    auto start = BenchClock::now();
+    ReplayStats stats = analyzeReplays(paths, pool);
+    double us = elapsedMicros(start, BenchClock::now());
+
+    std::cout << stats.files << " replays (" << stats.badFiles << " unreadable), "
+              << stats.ticks << " ticks, " << stats.games << " finished games, "
+              << stats.food << " food eaten, " << stats.obstacleSpawns << " obstacles spawned\n"
+              << "deaths: " << stats.deathsSelf << " self, "
+              << stats.deathsObstacle << " obstacle\n"
+              << "scores:\n";
+    for (const auto& s : stats.scores) {
+        std::cout << "  " << s.first << ": " << s.second << "\n";
+    }
+    std::cout << "(" << us / 1000.0 << "ms on " << pool.size() << " threads)\n";
+    return stats.badFiles == 0 ? 0 : 1;
+}
+
+// `--replay <file>`: play a recording to the end without a window.
+inline int runReplay(const std::string& path) {
+    ReplayPlayer player;
+    if (!player.load(path)) {
+        std::cerr << "Not a replay file: " << path << "\n";
+        return 1;
+    }
+    GameWorld world;
+    int games = 1;
+    int best  = 0;
+    auto start = BenchClock::now();
+    player.start(world);
+    while (!player.finished()) {
+        TickEvent ev = player.advance(world);
+        best = std::max(best, world.score);
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            world.reset();
+            games++;
+        }
+    }
+    double us = elapsedMicros(start, BenchClock::now());
+    std::cout << path << ": seed=" << player.info().seed
+              << " ticks=" << player.position()
+              << " games=" << games << " best score=" << best
+              << " (" << player.position() / (us / 1e6) << " ticks/s)\n";
+    return 0;
+}
+
+inline int runBenchmarks() {
+    benchTickDeterminism();
+    benchPilot<Autopilot>("autopilot");
+    benchPilot<HamiltonPilot>("hamiltonian pilot");
+    benchLookahead();
+    benchReplay();
+    benchReplaySeek();
+    benchReplayAnalytics();
+    benchRewind();
+    benchRewindShortGames();
+    benchSnakeRuns();
+    benchFieldOfView(GRID_COLS, GRID_ROWS, FLASHLIGHT_RADIUS_BLOCKS);
+    benchFieldOfView(1024, 1024, 50);
+    benchLightMap(GRID_COLS, GRID_ROWS, 400);
+    benchLightMap(256, 256, 4000);
+    benchStatsStore();
+    benchResourcePack();
+    benchSpscRing();
+    benchSimulationThread();
+    benchInputLatency();
+    benchAudio();
+    benchRasterizer();
+    benchDistanceField(GRID_COLS, GRID_ROWS);
+    benchDistanceField(256, 256);
+    benchDistanceField(1024, 1024);
+    benchHamiltonCycle(GRID_COLS, GRID_ROWS);
+    benchHamiltonCycle(256, 256);
+    benchHamiltonCycle(1024, 1024);
+    return 0;
+}
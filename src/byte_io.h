@@ -0,0 +1,44 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+//-------------------------------------------------------
+//                  LITTLE-ENDIAN BYTES
+//-------------------------------------------------------
+// Helpers for the on-disk formats, which store every integer
+// little-endian regardless of the host.
+
+inline void putLE(std::vector<Uint8>& out, Uint64 value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        out.push_back((Uint8)(value >> (8 * i)));
+    }
+}
+
+inline Uint64 getLE(const Uint8* in, int bytes) {
+    Uint64 value = 0;
+    for (int i = 0; i < bytes; i++) {
+        value |= (Uint64)in[i] << (8 * i);
+    }
+    return value;
+}
+
+// CRC-32 (IEEE 802.3), for spotting torn or corrupted records.
+inline Uint32 crc32(const Uint8* data, size_t size) {
+    static const std::vector<Uint32> table = [] {
+        std::vector<Uint32> t(256);
+        for (Uint32 i = 0; i < 256; i++) {
+            Uint32 c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    Uint32 crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
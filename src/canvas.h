@@ -0,0 +1,191 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "software_raster.h"
+#include "thread_pool.h"
+
+// Who turns the frame's shapes into pixels.
+enum class RenderBackend {
+    AUTO,        // SOFTWARE when SDL itself fell back to software rendering
+    SDL,         // one SDL_Render* call per shape
+    SOFTWARE     // SoftwareRasterizer, uploaded once per frame
+};
+
+inline const char* backendName(RenderBackend backend) {
+    switch (backend) {
+        case RenderBackend::SDL:      return "sdl";
+        case RenderBackend::SOFTWARE: return "software";
+        default:                      return "auto";
+    }
+}
+
+//-------------------------------------------------------
+//                        CANVAS
+//-------------------------------------------------------
+// What the game draws through. With the SDL backend every call goes
+// straight to the renderer. With the software backend shapes land in a
+// SoftwareRasterizer and present() uploads the finished frame into one
+// streaming texture; SDL's own software renderer pays a lock, a clip and a
+// format lookup for every rectangle and line, which adds up to most of the
+// frame with 3000 blades of grass.
+//
+// Text arrives as ready textures and is drawn by SDL in both cases. On the
+// software backend it is held until present() and drawn over the frame,
+// which is what the game wants anyway: no shape is drawn over text.
+//
+// The software frame is rasterized in tiles spread over rasterThreads
+// threads, the presenting thread being one of them.
+class Canvas {
+public:
+    Canvas()
+        : renderer(nullptr),
+          frame(nullptr),
+          active(RenderBackend::SDL),
+          finished(false),
+          threads(1)
+    {
+    }
+
+    ~Canvas() {
+        release();
+    }
+
+    // Pick a backend for renderer; returns the one in use. Falls back to
+    // SDL if the frame texture cannot be created.
+    RenderBackend init(SDL_Renderer* r, int width, int height, RenderBackend backend) {
+        release();
+        renderer = r;
+        active   = RenderBackend::SDL;
+        if (backend == RenderBackend::AUTO) {
+            SDL_RendererInfo info;
+            bool softwareFallback = renderer && SDL_GetRendererInfo(renderer, &info) == 0 &&
+                                    (info.flags & SDL_RENDERER_SOFTWARE);
+            backend = softwareFallback ? RenderBackend::SOFTWARE : RenderBackend::SDL;
+        }
+        if (backend == RenderBackend::SOFTWARE && renderer) {
+            frame = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888,
+                                      SDL_TEXTUREACCESS_STREAMING, width, height);
+            if (frame) {
+                SDL_SetTextureBlendMode(frame, SDL_BLENDMODE_NONE);
+                raster.resize(width, height);
+                active = RenderBackend::SOFTWARE;
+            }
+        }
+        return active;
+    }
+
+    // Destroy the frame texture; call before destroying the renderer.
+    void release() {
+        if (frame) {
+            SDL_DestroyTexture(frame);
+            frame = nullptr;
+        }
+        deferred.clear();
+    }
+
+    RenderBackend backend() const { return active; }
+
+    // Threads rasterizing the software frame; 0 is one per hardware
+    // thread. Call after init(); the SDL backend starts none.
+    void setRasterThreads(unsigned count) {
+        if (count == 0) {
+            count = std::max(1u, std::thread::hardware_concurrency());
+        }
+        threads = frame ? count : 1;
+        pool.reset(threads > 1 ? new ThreadPool(threads - 1) : nullptr);
+    }
+
+    unsigned rasterThreads() const { return threads; }
+
+    void setColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+        if (frame) {
+            raster.setColor(r, g, b, a);
+        } else {
+            SDL_SetRenderDrawColor(renderer, r, g, b, a);
+        }
+    }
+
+    // Only NONE and BLEND are used.
+    void setBlendMode(SDL_BlendMode mode) {
+        if (frame) {
+            raster.setBlend(mode == SDL_BLENDMODE_BLEND);
+        } else {
+            SDL_SetRenderDrawBlendMode(renderer, mode);
+        }
+    }
+
+    void clear() {
+        if (frame) {
+            raster.clear();
+        } else {
+            SDL_RenderClear(renderer);
+        }
+    }
+
+    void fillRect(const SDL_Rect& rect) {
+        if (frame) {
+            raster.fillRect(rect.x, rect.y, rect.w, rect.h);
+        } else {
+            SDL_RenderFillRect(renderer, &rect);
+        }
+    }
+
+    void drawLine(int x0, int y0, int x1, int y1) {
+        if (frame) {
+            raster.drawLine(x0, y0, x1, y1);
+        } else {
+            SDL_RenderDrawLine(renderer, x0, y0, x1, y1);
+        }
+    }
+
+    // The texture must stay alive until present().
+    void drawTexture(SDL_Texture* texture, const SDL_Rect& dst) {
+        if (frame) {
+            deferred.push_back(Copy{texture, dst});
+        } else {
+            SDL_RenderCopy(renderer, texture, nullptr, &dst);
+        }
+    }
+
+    // Hand the whole frame to the renderer, short of showing it: on the
+    // software backend, rasterize it and copy it and the held text over.
+    // present() does this itself if it has not been done.
+    void finish() {
+        if (frame && !finished) {
+            raster.render(pool.get());
+            SDL_UpdateTexture(frame, nullptr, raster.data(), raster.pitch());
+            SDL_RenderCopy(renderer, frame, nullptr, nullptr);
+            for (const Copy& c : deferred) {
+                SDL_RenderCopy(renderer, c.texture, nullptr, &c.dst);
+            }
+            deferred.clear();
+        }
+        finished = true;
+    }
+
+    // With vsync this waits for the display.
+    void present() {
+        finish();
+        SDL_RenderPresent(renderer);
+        finished = false;
+    }
+
+private:
+    struct Copy {
+        SDL_Texture* texture;
+        SDL_Rect     dst;
+    };
+
+    SDL_Renderer*      renderer;
+    SDL_Texture*       frame;       // null on the SDL backend
+    RenderBackend      active;
+    bool               finished;    // finish() done for this frame
+    SoftwareRasterizer raster;
+    std::vector<Copy>  deferred;    // text waiting for present()
+    unsigned           threads;
+    std::unique_ptr<ThreadPool> pool;    // the other threads - 1 rasterizers
+};
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <algorithm>
+#include <climits>
+
+//-------------------------------------------------------
+//                INCREMENTAL DISTANCE FIELD
+//-------------------------------------------------------
+// Multi-source BFS distance (in steps, with wrap-around) from every free
+// cell to the nearest source cell, e.g. food. When a single cell turns
+// solid or free, only the region whose shortest paths went through it is
+// repaired; the rest of the field is left alone. A bot can then walk
+// downhill by looking at four neighbours.
+class DistanceField {
+public:
+    static constexpr int UNREACHABLE = INT_MAX;
+
+    DistanceField(int width, int height)
+        : width(width),
+          height(height),
+          dist(width * height, UNREACHABLE),
+          solid(width * height, 0),
+          source(width * height, 0),
+          mark(width * height, 0),
+          stamp(0)
+    {
+        queue.reserve(width * height);
+        region.reserve(width * height);
+        seeds.reserve(width * height);
+    }
+
+    int  cols() const { return width; }
+    int  rows() const { return height; }
+    int  at(int cell) const { return dist[cell]; }
+    bool isSolid(int cell) const { return solid[cell] != 0; }
+
+    int neighbour(int cell, int k) const {
+        int x = cell % width;
+        int y = cell / width;
+        switch (k) {
+            case 0:  x = (x + 1 == width) ? 0 : x + 1; break;
+            case 1:  x = (x == 0) ? width - 1 : x - 1; break;
+            case 2:  y = (y + 1 == height) ? 0 : y + 1; break;
+            default: y = (y == 0) ? height - 1 : y - 1; break;
+        }
+        return y * width + x;
+    }
+
+    // Forget all sources and walls; the caller sets them again and then
+    // calls rebuild().
+    void clear() {
+        std::fill(solid.begin(), solid.end(), 0);
+        std::fill(source.begin(), source.end(), 0);
+    }
+
+    // Flag setters for use before rebuild(); they do not repair the field.
+    void markSolid(int cell, bool on)  { solid[cell]  = on ? 1 : 0; }
+    void markSource(int cell, bool on) { source[cell] = on ? 1 : 0; }
+
+    // Full recomputation from the current walls and sources.
+    void rebuild() {
+        std::fill(dist.begin(), dist.end(), UNREACHABLE);
+        queue.clear();
+        for (int i = 0; i < width * height; i++) {
+            if (source[i] && !solid[i]) {
+                dist[i] = 0;
+                queue.push_back(i);
+            }
+        }
+        propagate(0);
+    }
+
+    // Turn a cell solid (e.g. the new head) or free (e.g. the old tail) and
+    // repair the field around it.
+    void setSolid(int cell, bool on) {
+        if ((solid[cell] != 0) == on) {
+            return;
+        }
+        solid[cell] = on ? 1 : 0;
+        if (on) {
+            invalidateFrom(cell);
+        } else {
+            lower(cell);
+        }
+    }
+
+    // Add or remove a source and repair the field around it.
+    void setSource(int cell, bool on) {
+        if ((source[cell] != 0) == on) {
+            return;
+        }
+        source[cell] = on ? 1 : 0;
+        if (solid[cell]) {
+            return;
+        }
+        if (on) {
+            lower(cell);
+        } else {
+            invalidateFrom(cell);
+        }
+    }
+
+    // Neighbour index (0..3) with the smallest distance, or -1 when every
+    // neighbour is solid or cut off from all sources.
+    int downhill(int cell) const {
+        int best = -1;
+        int bestDist = UNREACHABLE;
+        for (int k = 0; k < 4; k++) {
+            int n = neighbour(cell, k);
+            if (!solid[n] && dist[n] < bestDist) {
+                bestDist = dist[n];
+                best = k;
+            }
+        }
+        return best;
+    }
+
+private:
+    int width;
+    int height;
+    std::vector<int>    dist;
+    std::vector<Uint8>  solid;
+    std::vector<Uint8>  source;
+    std::vector<Uint32> mark;     // cell already queued when == stamp
+    Uint32              stamp;
+    std::vector<int>    queue;
+    std::vector<int>    region;
+    std::vector<int>    seeds;
+
+    void nextStamp() {
+        if (++stamp == 0) {
+            std::fill(mark.begin(), mark.end(), 0);
+            stamp = 1;
+        }
+    }
+
+    // Breadth-first relaxation of everything in queue from position head.
+    // Cells must be queued in nondecreasing distance order.
+    void propagate(size_t head) {
+        while (head < queue.size()) {
+            int cur = queue[head++];
+            int next = dist[cur] + 1;
+            for (int k = 0; k < 4; k++) {
+                int n = neighbour(cur, k);
+                if (!solid[n] && next < dist[n]) {
+                    dist[n] = next;
+                    queue.push_back(n);
+                }
+            }
+        }
+    }
+
+    // A cell opened up or became a source: its distance can only drop, and
+    // the drop spreads outward until it stops helping.
+    void lower(int cell) {
+        int d = source[cell] ? 0 : UNREACHABLE;
+        if (d != 0) {
+            for (int k = 0; k < 4; k++) {
+                int n = neighbour(cell, k);
+                if (!solid[n] && dist[n] != UNREACHABLE) {
+                    d = std::min(d, dist[n] + 1);
+                }
+            }
+        }
+        dist[cell] = d;
+        if (d == UNREACHABLE) {
+            return;
+        }
+        queue.clear();
+        queue.push_back(cell);
+        propagate(0);
+    }
+
+    // A cell stopped being a usable path or a source. Find every cell
+    // whose shortest path depended on it, reset them, then re-grow their
+    // distances from the intact cells around the region.
+    void invalidateFrom(int cell) {
+        int old = dist[cell];
+        nextStamp();
+        region.clear();
+        region.push_back(cell);
+        mark[cell] = stamp;
+        dist[cell] = UNREACHABLE;
+        if (old == UNREACHABLE) {
+            if (!solid[cell]) {
+                lower(cell);
+            }
+            return;
+        }
+
+        // Layer by layer, a cell one step farther than an invalidated cell
+        // is lost too unless another neighbour one step closer survives.
+        // The queue is FIFO, so a whole layer is settled before the next one
+        // is examined and the survivor check is exact.
+        queue.clear();
+        for (int k = 0; k < 4; k++) {
+            int n = neighbour(cell, k);
+            if (!solid[n] && mark[n] != stamp && dist[n] == old + 1) {
+                mark[n] = stamp;
+                queue.push_back(n);
+            }
+        }
+        size_t head = 0;
+        while (head < queue.size()) {
+            int cur = queue[head++];
+            int d = dist[cur];
+            bool supported = source[cur] != 0;
+            for (int k = 0; k < 4 && !supported; k++) {
+                int n = neighbour(cur, k);
+                supported = !solid[n] && dist[n] == d - 1;
+            }
+            if (supported) {
+                continue;
+            }
+            region.push_back(cur);
+            for (int k = 0; k < 4; k++) {
+                int n = neighbour(cur, k);
+                if (!solid[n] && mark[n] != stamp && dist[n] == d + 1) {
+                    mark[n] = stamp;
+                    queue.push_back(n);
+                }
+            }
+            dist[cur] = UNREACHABLE;
+        }
+
+        // Seed each region cell from its best intact neighbour, then run a
+        // BFS that merges the sorted seeds with the growing frontier.
+        seeds.clear();
+        for (int r : region) {
+            if (solid[r]) {
+                continue;
+            }
+            int d = source[r] ? 0 : UNREACHABLE;
+            for (int k = 0; k < 4 && d != 0; k++) {
+                int n = neighbour(r, k);
+                if (!solid[n] && dist[n] != UNREACHABLE) {
+                    d = std::min(d, dist[n] + 1);
+                }
+            }
+            if (d != UNREACHABLE) {
+                dist[r] = d;
+                seeds.push_back(r);
+            }
+        }
+        std::sort(seeds.begin(), seeds.end(),
+            [this](int a, int b) { return dist[a] < dist[b]; });
+
+        queue.clear();
+        size_t head2 = 0;
+        size_t s = 0;
+        while (s < seeds.size() || head2 < queue.size()) {
+            int cur;
+            if (head2 >= queue.size() ||
+                (s < seeds.size() && dist[seeds[s]] <= dist[queue[head2]])) {
+                cur = seeds[s++];
+            } else {
+                cur = queue[head2++];
+            }
+            int next = dist[cur] + 1;
+            for (int k = 0; k < 4; k++) {
+                int n = neighbour(cur, k);
+                if (!solid[n] && next < dist[n]) {
+                    dist[n] = next;
+                    queue.push_back(n);
+                }
+            }
+        }
+    }
+};
@@ -0,0 +1,200 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <algorithm>
+
+// The eight octants around the origin, as the map from an octant's local
+// (col, row) to board (dx, dy): dx = col * xx + row * xy, dy = col * yx +
+// row * yy. Rows run away from the origin and col goes from -row to 0.
+struct FovOctant {
+    int xx, xy, yx, yy;
+};
+
+const FovOctant FOV_OCTANTS[8] = {
+    { 1,  0,  0,  1}, { 0,  1,  1,  0}, { 0, -1,  1,  0}, {-1,  0,  0,  1},
+    {-1,  0,  0, -1}, { 0, -1, -1,  0}, { 0,  1, -1,  0}, { 1,  0,  0, -1}
+};
+
+//-------------------------------------------------------
+//                  FIELD OF VIEW
+//-------------------------------------------------------
+// Which cells can be seen from an origin cell within a radius, with wall
+// cells blocking the view behind them. Uses recursive shadowcasting: each
+// octant is scanned row by row outwards, and a run of walls narrows the
+// slopes the next rows are scanned over. The board does not wrap.
+//
+// The result is kept per octant. Moving the origin or changing the radius
+// recomputes everything; a wall appearing or going away recomputes only
+// the octants whose scanned wedge holds that cell.
+class FieldOfView {
+public:
+    FieldOfView(int width, int height)
+        : width(width),
+          height(height),
+          walls(width * height, 0),
+          seen(width * height, 0),
+          origin(-1),
+          radius(0),
+          stale(0xFF),
+          recomputed(0)
+    {
+    }
+
+    int cols() const { return width; }
+    int rows() const { return height; }
+
+    // Nonzero for every visible cell, the origin included.
+    bool visible(int cell) const { return seen[cell] != 0; }
+    const std::vector<Uint8>& visibility() const { return seen; }
+
+    // Make the walls exactly the given cells (repeats allowed). Octants
+    // touched by a difference from the last call are marked stale.
+    void setWalls(const std::vector<int>& cells) {
+        for (int c : cells) {
+            addWall(c);       // only a new wall counts, not one on the old list
+        }
+        for (int c : wallList) {
+            removeWall(c);    // only a wall on the old list alone goes away
+        }
+        wallList = cells;
+    }
+
+    // Single changes, for callers that track them; not to be mixed with
+    // setWalls(), which keeps its own list.
+    void addWall(int cell) {
+        if (walls[cell]++ == 0) {
+            invalidate(cell);
+        }
+    }
+
+    void removeWall(int cell) {
+        if (--walls[cell] == 0) {
+            invalidate(cell);
+        }
+    }
+
+    // Bring the view up to date for origin and radius (in cells).
+    void update(int from, int r) {
+        if (from != origin || r != radius) {
+            origin = from;
+            radius = r;
+            stale  = 0xFF;
+        }
+        if (stale == 0) {
+            return;
+        }
+        for (int o = 0; o < 8; o++) {
+            if (stale & (1 << o)) {
+                recomputeOctant(o);
+            }
+        }
+        stale = 0;
+    }
+
+    // Octant scans done since construction, for benchmarks.
+    Uint64 octantsRecomputed() const { return recomputed; }
+
+private:
+    int width;
+    int height;
+    std::vector<Uint8> walls;      // walls on each cell
+    std::vector<Uint8> seen;       // octants (plus origin) seeing each cell
+    std::vector<int>   wallList;   // as last given to setWalls()
+    std::vector<int>   octantCells[8];
+    int    origin;
+    int    radius;
+    Uint8  stale;                  // octants to recompute, one bit each
+    Uint64 recomputed;
+
+    bool wallAt(int x, int y) const {
+        return x >= 0 && y >= 0 && x < width && y < height && walls[y * width + x] != 0;
+    }
+
+    // Mark the octants whose wedge (rows 1..radius) contains cell.
+    void invalidate(int cell) {
+        if (origin < 0) {
+            return;
+        }
+        int dx = cell % width - origin % width;
+        int dy = cell / width - origin / width;
+        for (int o = 0; o < 8; o++) {
+            const FovOctant& t = FOV_OCTANTS[o];
+            // The maps are signed permutations, so the inverse is the transpose.
+            int col = dx * t.xx + dy * t.yx;
+            int row = dx * t.xy + dy * t.yy;
+            if (row >= 1 && row <= radius && col <= 0 && col >= -row) {
+                stale |= (Uint8)(1 << o);
+            }
+        }
+    }
+
+    void recomputeOctant(int o) {
+        std::vector<int>& cells = octantCells[o];
+        for (int c : cells) {
+            seen[c]--;
+        }
+        cells.clear();
+        // The origin is counted once, with octant 0.
+        if (o == 0 && origin >= 0) {
+            seen[origin]++;
+            cells.push_back(origin);
+        }
+        if (origin >= 0) {
+            castLight(o, 1, 1.0f, 0.0f);
+        }
+        recomputed++;
+    }
+
+    // Scan rows from row outwards over slopes [end, start], where the
+    // slope of a cell is -col / row (1 at the diagonal, 0 on the axis).
+    void castLight(int o, int row, float start, float end) {
+        if (start < end) {
+            return;
+        }
+        const FovOctant& t = FOV_OCTANTS[o];
+        const int ox = origin % width;
+        const int oy = origin / width;
+        const int radius2 = radius * radius;
+        std::vector<int>& cells = octantCells[o];
+        float nextStart = start;
+        for (int j = row; j <= radius; j++) {
+            bool blocked = false;
+            for (int col = -j; col <= 0; col++) {
+                // Slopes of this cell's far and near corners.
+                float left  = (-col + 0.5f) / (j - 0.5f);
+                float right = (-col - 0.5f) / (j + 0.5f);
+                if (start < right) {
+                    continue;
+                }
+                if (end > left) {
+                    break;
+                }
+                int x = ox + col * t.xx + j * t.xy;
+                int y = oy + col * t.yx + j * t.yy;
+                bool inside = x >= 0 && y >= 0 && x < width && y < height;
+                if (inside && col * col + j * j <= radius2) {
+                    int c = y * width + x;
+                    seen[c]++;
+                    cells.push_back(c);
+                }
+                bool wall = wallAt(x, y);
+                if (blocked) {
+                    if (wall) {
+                        nextStart = right;
+                    } else {
+                        blocked = false;
+                        start = nextStart;
+                    }
+                } else if (wall && j < radius) {
+                    blocked = true;
+                    castLight(o, j + 1, start, left);
+                    nextStart = right;
+                }
+            }
+            if (blocked) {
+                break;
+            }
+        }
+    }
+};
@@ -0,0 +1,428 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+#include <algorithm>
+
+//-------------------------------------------------------
+//                    BOARD CONSTANTS
+//-------------------------------------------------------
+const int SCREEN_WIDTH       = 800;
+const int SCREEN_HEIGHT      = 600;
+const int GRID_SIZE          = 20;
+
+// Board dimensions in cells.
+const int GRID_COLS          = SCREEN_WIDTH / GRID_SIZE;
+const int GRID_ROWS          = SCREEN_HEIGHT / GRID_SIZE;
+
+struct Point {
+    int x;
+    int y;
+    bool operator==(const Point& other) const {
+        return x == other.x && y == other.y;
+    }
+};
+
+// Flat index of the grid cell holding a pixel-space point.
+inline int cellIndex(const Point& p) {
+    return (p.y / GRID_SIZE) * GRID_COLS + p.x / GRID_SIZE;
+}
+
+// Pixel-space top-left corner of a grid cell.
+inline Point cellPoint(int index) {
+    return {(index % GRID_COLS) * GRID_SIZE, (index / GRID_COLS) * GRID_SIZE};
+}
+
+// The four moves in a fixed order: east, west, south, north.
+const Point DIRECTIONS[4] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+
+// Cell reached from `cell` by moving in DIRECTIONS[k], wrapping at edges.
+inline int neighbourCell(int cell, int k) {
+    int x = (cell % GRID_COLS + DIRECTIONS[k].x + GRID_COLS) % GRID_COLS;
+    int y = (cell / GRID_COLS + DIRECTIONS[k].y + GRID_ROWS) % GRID_ROWS;
+    return y * GRID_COLS + x;
+}
+
+// Direction from the cell at a to a neighbouring one at b, wrapping at
+// edges, or {0, 0} if b is not next to a. Both are pixel-space points.
+inline Point stepDirection(const Point& a, const Point& b) {
+    for (int k = 0; k < 4; k++) {
+        if (neighbourCell(cellIndex(a), k) == cellIndex(b)) {
+            return DIRECTIONS[k];
+        }
+    }
+    return {0, 0};
+}
+
+// Occupancy flags kept per grid cell.
+const Uint8 CELL_SNAKE    = 1;
+const Uint8 CELL_OBSTACLE = 2;
+const Uint8 CELL_FOOD     = 4;
+
+//-------------------------------------------------------
+//                 DETERMINISTIC RANDOM
+//-------------------------------------------------------
+// Small xorshift64* generator. All gameplay randomness goes through this
+// instead of std::rand, so the same seed always produces the same game.
+struct Rng {
+    Uint64 state;
+
+    void seed(Uint64 s) {
+        // xorshift must never hold an all-zero state.
+        state = s ? s : 0x9E3779B97F4A7C15ull;
+    }
+
+    Uint32 next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return static_cast<Uint32>((state * 0x2545F4914F6CDD1Dull) >> 32);
+    }
+
+    // Uniform-ish value in [0, n).
+    int range(int n) {
+        return static_cast<int>(next() % static_cast<Uint32>(n));
+    }
+};
+
+// What a single simulation tick did.
+enum class TickEvent {
+    NONE,           // nothing to move (no snake yet)
+    MOVED,
+    ATE,
+    HIT_SELF,
+    HIT_OBSTACLE
+};
+
+// Result of the first tick phase: where the head goes and what happens
+// there, computed without touching any state.
+struct MovePlan {
+    Point     newHead;
+    TickEvent outcome;
+};
+
+// Everything needed to take back one step(). Food lists replaced by a
+// meal are parked in GameWorld::foodStash rather than in the record, so
+// records stay small and fixed-size.
+struct UndoRecord {
+    TickEvent outcome;
+    Point     direction;
+    Point     tail;            // segment dropped by a plain move
+    Uint64    rngState;
+    int       score;
+    int       lastFreedCell;
+    Uint32    foodMark;        // where the old food list starts in foodStash
+    Uint32    foodCount;
+    Uint32    obstacleCount;   // obstacles.size() before the step
+};
+
+//-------------------------------------------------------
+//                      GAME WORLD
+//-------------------------------------------------------
+// The simulation state of one game, free of any SDL video/audio calls.
+// A tick runs in two phases: planMove() works out the outcome from a
+// read-only view of the board, then resolveMove() applies it. Given the
+// same seed and the same direction on every tick, two worlds stay
+// bit-identical.
+class GameWorld {
+public:
+    std::vector<Point> snake;
+    std::vector<Point> foodItems;
+    std::vector<Point> obstacles;
+    std::vector<Uint8> cells;      // CELL_* flags, one byte per grid cell
+    Point  direction;
+    int    score;
+    Uint64 seedValue;
+    Rng    rng;
+
+    // Change tracking for incremental consumers (e.g. the autopilot's
+    // distance field). ticks counts applied moves since seed(),
+    // layoutVersion changes whenever food or obstacles are respawned, and
+    // lastFreedCell is the tail cell the last move gave up (-1 if none).
+    Uint64 ticks;
+    Uint32 layoutVersion;
+    int    lastFreedCell;
+
+    // Spawn counts, copied from the config menu when a game starts.
+    int numFoodItems;
+    int numObstacles;
+
+    // Undo log for search and rewind. While recordUndo is set, every step()
+    // pushes exactly one record and undo() restores the state before it
+    // bit for bit. Once both vectors have grown to their working size,
+    // stepping and undoing no longer allocate.
+    bool                    recordUndo;
+    std::vector<UndoRecord> undoLog;
+    std::vector<Point>      foodStash;
+
+    GameWorld()
+        : cells(GRID_COLS * GRID_ROWS, 0),
+          direction({1, 0}),
+          score(0),
+          seedValue(0),
+          ticks(0),
+          layoutVersion(0),
+          lastFreedCell(-1),
+          numFoodItems(10),
+          numObstacles(15),
+          recordUndo(false)
+    {
+        rng.seed(0);
+    }
+
+    // Start a new run of games from the given seed.
+    void seed(Uint64 s) {
+        seedValue = s;
+        rng.seed(s);
+        ticks = 0;
+    }
+
+    // Put a fresh snake on the board. The RNG keeps running, so a restart
+    // after a collision is still determined by the original seed.
+    void reset() {
+        std::fill(cells.begin(), cells.end(), 0);
+        snake.clear();
+        snake.push_back({SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2});
+        cells[cellIndex(snake[0])] |= CELL_SNAKE;
+        direction = {1, 0};
+        score     = 0;
+        layoutVersion++;
+        lastFreedCell = -1;
+        undoLog.clear();
+        foodStash.clear();
+
+        foodItems.clear();
+        obstacles.clear();
+        spawnFood();
+        spawnObstacles(numObstacles);
+    }
+
+    // Advance one tick. On a collision nothing is changed; the caller
+    // decides when to reset().
+    TickEvent step() {
+        MovePlan plan = planMove();
+        return resolveMove(plan);
+    }
+
+    // Phase 1: compute the next head and its outcome.
+    MovePlan planMove() const {
+        MovePlan plan = {{0, 0}, TickEvent::NONE};
+        if (snake.empty()) {
+            return plan;
+        }
+
+        Point newHead = {
+            snake[0].x + direction.x * GRID_SIZE,
+            snake[0].y + direction.y * GRID_SIZE
+        };
+
+        // Wrap horizontally
+        if (newHead.x < 0) {
+            newHead.x = SCREEN_WIDTH - GRID_SIZE;
+        } else if (newHead.x >= SCREEN_WIDTH) {
+            newHead.x = 0;
+        }
+
+        // Wrap vertically
+        if (newHead.y < 0) {
+            newHead.y = SCREEN_HEIGHT - GRID_SIZE;
+        } else if (newHead.y >= SCREEN_HEIGHT) {
+            newHead.y = 0;
+        }
+        plan.newHead = newHead;
+
+        // The whole body counts, tail included, since the tail only moves
+        // once the head has.
+        Uint8 cell = cells[cellIndex(newHead)];
+        if (cell & CELL_SNAKE) {
+            plan.outcome = TickEvent::HIT_SELF;
+        } else if (cell & CELL_OBSTACLE) {
+            plan.outcome = TickEvent::HIT_OBSTACLE;
+        } else if (cell & CELL_FOOD) {
+            plan.outcome = TickEvent::ATE;
+        } else {
+            plan.outcome = TickEvent::MOVED;
+        }
+        return plan;
+    }
+
+    // Phase 2: apply a plan from planMove(). All random draws happen here,
+    // in a fixed order, which keeps ticks reproducible.
+    TickEvent resolveMove(const MovePlan& plan) {
+        if (recordUndo) {
+            UndoRecord r;
+            r.outcome       = plan.outcome;
+            r.direction     = direction;
+            r.tail          = snake.empty() ? Point{0, 0} : snake.back();
+            r.rngState      = rng.state;
+            r.score         = score;
+            r.lastFreedCell = lastFreedCell;
+            r.foodMark      = (Uint32)foodStash.size();
+            r.foodCount     = 0;
+            r.obstacleCount = (Uint32)obstacles.size();
+            if (plan.outcome == TickEvent::ATE) {
+                foodStash.insert(foodStash.end(), foodItems.begin(), foodItems.end());
+                r.foodCount = (Uint32)foodItems.size();
+            }
+            undoLog.push_back(r);
+        }
+
+        switch (plan.outcome) {
+            case TickEvent::MOVED:
+                snake.insert(snake.begin(), plan.newHead);
+                cells[cellIndex(plan.newHead)] |= CELL_SNAKE;
+                lastFreedCell = cellIndex(snake.back());
+                cells[lastFreedCell] &= ~CELL_SNAKE;
+                snake.pop_back();
+                ticks++;
+                break;
+            case TickEvent::ATE:
+                snake.insert(snake.begin(), plan.newHead);
+                cells[cellIndex(plan.newHead)] |= CELL_SNAKE;
+                lastFreedCell = -1;
+                ticks++;
+                layoutVersion++;
+                score++;
+                // Clear old food and spawn new set
+                for (const auto& f : foodItems) {
+                    cells[cellIndex(f)] &= ~CELL_FOOD;
+                }
+                foodItems.clear();
+                spawnFood();
+                spawnObstacles(5);
+                break;
+            default:
+                break;
+        }
+        return plan.outcome;
+    }
+
+    // Copy the game state of another world, leaving this world's undo log
+    // and its vectors' capacity alone.
+    void copyStateFrom(const GameWorld& other) {
+        snake         = other.snake;
+        foodItems     = other.foodItems;
+        obstacles     = other.obstacles;
+        cells         = other.cells;
+        direction     = other.direction;
+        score         = other.score;
+        seedValue     = other.seedValue;
+        rng           = other.rng;
+        ticks         = other.ticks;
+        layoutVersion = other.layoutVersion;
+        lastFreedCell = other.lastFreedCell;
+        numFoodItems  = other.numFoodItems;
+        numObstacles  = other.numObstacles;
+        undoLog.clear();
+        foodStash.clear();
+    }
+
+    // Position in the undo log, to hand back to rewindTo() later.
+    size_t mark() const {
+        return undoLog.size();
+    }
+
+    void rewindTo(size_t m) {
+        while (undoLog.size() > m) {
+            undo();
+        }
+    }
+
+    // Forget the oldest count records, and the food they parked, to keep
+    // a long-running log bounded. Marks taken earlier become invalid.
+    void dropOldestUndo(size_t count) {
+        count = std::min(count, undoLog.size());
+        const Uint32 dropFood = (count < undoLog.size()) ? undoLog[count].foodMark
+                                                         : (Uint32)foodStash.size();
+        undoLog.erase(undoLog.begin(), undoLog.begin() + count);
+        foodStash.erase(foodStash.begin(), foodStash.begin() + dropFood);
+        for (auto& r : undoLog) {
+            r.foodMark -= dropFood;
+        }
+    }
+
+    // Take back the most recent recorded step.
+    void undo() {
+        if (undoLog.empty()) {
+            return;
+        }
+        const UndoRecord r = undoLog.back();
+        undoLog.pop_back();
+
+        if (r.outcome == TickEvent::MOVED || r.outcome == TickEvent::ATE) {
+            cells[cellIndex(snake.front())] &= ~CELL_SNAKE;
+            snake.erase(snake.begin());
+            ticks--;
+        }
+        if (r.outcome == TickEvent::MOVED) {
+            snake.push_back(r.tail);
+            cells[cellIndex(r.tail)] |= CELL_SNAKE;
+        } else if (r.outcome == TickEvent::ATE) {
+            // Obstacles may share a cell, so a cleared flag is put back if
+            // an older obstacle still sits there.
+            for (size_t i = r.obstacleCount; i < obstacles.size(); i++) {
+                cells[cellIndex(obstacles[i])] &= ~CELL_OBSTACLE;
+            }
+            for (size_t i = r.obstacleCount; i < obstacles.size(); i++) {
+                for (size_t j = 0; j < r.obstacleCount; j++) {
+                    if (obstacles[j] == obstacles[i]) {
+                        cells[cellIndex(obstacles[i])] |= CELL_OBSTACLE;
+                        break;
+                    }
+                }
+            }
+            obstacles.resize(r.obstacleCount);
+
+            for (const auto& f : foodItems) {
+                cells[cellIndex(f)] &= ~CELL_FOOD;
+            }
+            foodItems.assign(foodStash.begin() + r.foodMark,
+                             foodStash.begin() + r.foodMark + r.foodCount);
+            for (const auto& f : foodItems) {
+                cells[cellIndex(f)] |= CELL_FOOD;
+            }
+            foodStash.resize(r.foodMark);
+        }
+
+        direction     = r.direction;
+        rng.state     = r.rngState;
+        score         = r.score;
+        lastFreedCell = r.lastFreedCell;
+        // Never hand out an old version again: the layout after an undo and
+        // a different move can differ from what that version once meant.
+        layoutVersion++;
+    }
+
+    //---------------------------------------------------
+    //       SPAWNING FOOD & OBSTACLES
+    //---------------------------------------------------
+    void spawnFood() {
+        for (int i = 0; i < numFoodItems; i++) {
+            Point food;
+            bool validPos = false;
+            while (!validPos) {
+                food.x = rng.range(GRID_COLS) * GRID_SIZE;
+                food.y = rng.range(GRID_ROWS) * GRID_SIZE;
+                // check snake and obstacles
+                validPos = !(cells[cellIndex(food)] & (CELL_SNAKE | CELL_OBSTACLE));
+            }
+            foodItems.push_back(food);
+            cells[cellIndex(food)] |= CELL_FOOD;
+        }
+    }
+
+    void spawnObstacles(int count) {
+        for (int i = 0; i < count; i++) {
+            Point obs;
+            bool validPos = false;
+            while (!validPos) {
+                obs.x = rng.range(GRID_COLS) * GRID_SIZE;
+                obs.y = rng.range(GRID_ROWS) * GRID_SIZE;
+                // check snake and food
+                validPos = !(cells[cellIndex(obs)] & (CELL_SNAKE | CELL_FOOD));
+            }
+            obstacles.push_back(obs);
+            cells[cellIndex(obs)] |= CELL_OBSTACLE;
+        }
+    }
+};
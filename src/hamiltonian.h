@@ -0,0 +1,606 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+#include "game_world.h"
+#include "autopilot.h"
+
+//-------------------------------------------------------
+//                   HAMILTONIAN CYCLE
+//-------------------------------------------------------
+// A closed tour over the free cells of a wrapping board with even width
+// and height. The board is split into 2x2 blocks, a spanning tree is grown
+// over the blocks that hold no wall, and the tour runs around that tree,
+// so every cell of a tree block is visited exactly once.
+//
+// Inside a lone block the tour runs TL -> BL -> BR -> TR. A tree edge to a
+// neighbouring block swaps one of those steps for a step into the
+// neighbour, which splices the two loops together.
+//
+// The remaining free cells are then spliced in two at a time: a pair of
+// side-by-side cells, in one block or straddling two, goes in wherever
+// the tour steps along the pair of cells next to it, u -> v becoming
+// u -> a -> b -> v. That routes the tour around single walls and picks
+// up wall-free blocks cut off from the tree. A grid tour has as many
+// cells of each colour of the chessboard, so where the walls leave more
+// of one colour free some cells are left out; at 5% walls about nine in
+// ten free cells make it onto the tour.
+//
+// Limits. The tree needs wall-free blocks that join up, and past about
+// 15% walls they stop doing so: the tour shrinks to the few cells around
+// the root and splicing cannot make up for it. A build is a handful of
+// passes over the board plus one walk along the whole tour, around 20ms
+// for a 1024x1024 board, twice what a rebuild should cost there; the
+// game's own board takes well under a tenth of a millisecond.
+class HamiltonCycle {
+public:
+    static const Uint8 EDGE_EAST  = 1;
+    static const Uint8 EDGE_WEST  = 2;
+    static const Uint8 EDGE_SOUTH = 4;
+    static const Uint8 EDGE_NORTH = 8;
+
+    HamiltonCycle(int width, int height)
+        : width(width),
+          height(height),
+          blocksX(width / 2),
+          blocksY(height / 2),
+          edges(blocksX * blocksY, 0),
+          detours(blocksX * blocksY, 0),
+          onTour(blocksX * blocksY, 0),
+          walled(blocksX * blocksY, 0),
+          order(width * height, -1),
+          queue(blocksX * blocksY),
+          length(0)
+    {
+    }
+
+    int  size() const { return length; }
+    bool contains(int cell) const { return order[cell] >= 0; }
+    int  position(int cell) const { return order[cell]; }
+
+    // Steps from cell a forward along the tour to cell b.
+    int forwardDistance(int a, int b) const {
+        int d = order[b] - order[a];
+        return (d < 0) ? d + length : d;
+    }
+
+    int blockOf(int cell) const {
+        return ((cell / width) / 2) * blocksX + (cell % width) / 2;
+    }
+
+    // Grow a spanning tree over the wall-free blocks connected to
+    // rootCell's block, lay the tour around it and splice in what else
+    // fits. wall[cell] != 0 marks cells the tour must avoid.
+    void build(const std::vector<Uint8>& wall, int rootCell) {
+        const int blocks = blocksX * blocksY;
+        std::fill(edges.begin(), edges.end(), 0);
+        std::fill(onTour.begin(), onTour.end(), 0);
+        for (int by = 0; by < blocksY; by++) {
+            const Uint8* top    = &wall[(size_t)(by * 2) * width];
+            const Uint8* bottom = top + width;
+            Uint8* out = &walled[by * blocksX];
+            for (int bx = 0; bx < blocksX; bx++) {
+                out[bx] = (Uint8)((top[2 * bx] != 0) | (top[2 * bx + 1] != 0) << 1 |
+                                  (bottom[2 * bx] != 0) << 2 | (bottom[2 * bx + 1] != 0) << 3);
+            }
+        }
+
+        // The root block, or if that is walled the first wall-free one.
+        int root = blockOf(rootCell);
+        if (walled[root]) {
+            root = -1;
+            for (int b = 0; b < blocks && root < 0; b++) {
+                if (!walled[b]) {
+                    root = b;
+                }
+            }
+        }
+        if (root < 0) {
+            relabel();
+            return;
+        }
+
+        // Breadth-first over the wall-free blocks from the root; the steps
+        // that first reach each block are the tree. Queue entries hold a
+        // block's coordinates, which saves dividing them out again.
+        int head = 0;
+        int tail = 0;
+        onTour[root] = 0xF;
+        queue[tail++] = (root / blocksX) << 16 | (root % blocksX);
+        while (head < tail) {
+            const int bx = queue[head] & 0xFFFF;
+            const int by = queue[head] >> 16;
+            head++;
+            const int b = by * blocksX + bx;
+            for (int k = 0; k < 4; k++) {
+                int nx = bx;
+                int ny = by;
+                stepBlock(nx, ny, k);
+                const int n = ny * blocksX + nx;
+                if (walled[n] || onTour[n]) {
+                    continue;
+                }
+                onTour[n] = 0xF;
+                edges[b] |= EDGE_BIT[k];
+                edges[n] |= EDGE_BIT[OPPOSITE[k]];
+                queue[tail++] = ny << 16 | nx;
+            }
+        }
+
+        pending.clear();
+        for (int b = 0; b < blocks; b++) {
+            if (onTour[b] != 0xF && walled[b] != 0xF) {
+                pending.push_back(b);
+            }
+        }
+        spliceAll();
+        relabel();
+    }
+
+    // The cell at `cell` became a wall. Where the tour runs p -> c -> d
+    // -> q around a unit square with c the new wall, it is patched to
+    // p -> q, which leaves the order of every other cell as it was, and
+    // the free cell dropped with c may be spliced back in elsewhere.
+    // Otherwise the tour has to be rebuilt, and false is returned.
+    bool removeCell(int cell) {
+        const int b   = blockOf(cell);
+        const int bit = cornerBit(cell % width, cell / width);
+        walled[b] |= bit;
+        if (!(onTour[b] & bit)) {
+            return true;
+        }
+        if (length <= 4) {
+            return false;
+        }
+        const int before = previous(cell);
+        const int after  = next(cell);
+        if (adjacent(previous(before), after)) {
+            cutPair(before, cell);
+        } else if (adjacent(before, next(after))) {
+            cutPair(cell, after);
+        } else {
+            return false;
+        }
+        spliceAll();
+        relabel();
+        return true;
+    }
+
+    // The tour successor of a cell on the tour.
+    int next(int cell) const {
+        int x = cell % width;
+        int y = cell / width;
+        advance(x, y);
+        return y * width + x;
+    }
+
+private:
+    // Same order as DIRECTIONS: east, west, south, north.
+    static constexpr Uint8 EDGE_BIT[4] = {EDGE_EAST, EDGE_WEST, EDGE_SOUTH, EDGE_NORTH};
+    static constexpr int   OPPOSITE[4] = {1, 0, 3, 2};
+
+    int width;
+    int height;
+    int blocksX;
+    int blocksY;
+    std::vector<Uint8> edges;    // EDGE_* bits per block; corner bits << 4 of its detours
+    std::vector<Uint8> detours;  // 2 bits per corner: DIRECTIONS index of a detour
+    std::vector<Uint8> onTour;   // corner bits of a block's cells on the tour
+    std::vector<Uint8> walled;   // corner bits of a block's walls
+    std::vector<int>   order;    // tour position per cell, -1 if off the tour
+    std::vector<int>   queue;    // breadth-first queue used by build()
+    std::vector<int>   pending;  // blocks with free cells still off the tour
+    int length;
+
+    static int cornerBit(int x, int y) {
+        return 1 << ((x & 1) | (y & 1) << 1);
+    }
+
+    void stepBlock(int& bx, int& by, int k) const {
+        switch (k) {
+            case 0:  bx = (bx + 1 == blocksX) ? 0 : bx + 1; break;
+            case 1:  bx = (bx == 0) ? blocksX - 1 : bx - 1; break;
+            case 2:  by = (by + 1 == blocksY) ? 0 : by + 1; break;
+            default: by = (by == 0) ? blocksY - 1 : by - 1; break;
+        }
+    }
+
+    void stepCell(int& x, int& y, int k) const {
+        switch (k) {
+            case 0:  x = (x + 1 == width) ? 0 : x + 1; break;
+            case 1:  x = (x == 0) ? width - 1 : x - 1; break;
+            case 2:  y = (y + 1 == height) ? 0 : y + 1; break;
+            default: y = (y == 0) ? height - 1 : y - 1; break;
+        }
+    }
+
+    int neighbourOf(int cell, int k) const {
+        int x = cell % width;
+        int y = cell / width;
+        stepCell(x, y, k);
+        return y * width + x;
+    }
+
+    // DIRECTIONS index of the step from cell a to its neighbour b, or -1.
+    int stepBetween(int a, int b) const {
+        for (int k = 0; k < 4; k++) {
+            if (neighbourOf(a, k) == b) {
+                return k;
+            }
+        }
+        return -1;
+    }
+
+    bool adjacent(int a, int b) const {
+        return a >= 0 && b >= 0 && stepBetween(a, b) >= 0;
+    }
+
+    // The cell the tour reaches cell from: the neighbour whose successor
+    // it is.
+    int previous(int cell) const {
+        for (int k = 0; k < 4; k++) {
+            int n = neighbourOf(cell, k);
+            if (order[n] >= 0 && next(n) == cell) {
+                return n;
+            }
+        }
+        return -1;
+    }
+
+    bool cellOnTour(int x, int y) const {
+        return (onTour[(y >> 1) * blocksX + (x >> 1)] & cornerBit(x, y)) != 0;
+    }
+
+    // Free, and not on the tour yet.
+    bool cellOpen(int x, int y) const {
+        const int b = (y >> 1) * blocksX + (x >> 1);
+        return ((walled[b] | onTour[b]) & cornerBit(x, y)) == 0;
+    }
+
+    // Send the tour from (x, y) in direction k instead of round its block.
+    void setDetour(int x, int y, int k) {
+        const int b = (y >> 1) * blocksX + (x >> 1);
+        const int corner = (x & 1) | (y & 1) << 1;
+        edges[b]  |= (Uint8)(1 << (corner + 4));
+        detours[b] = (Uint8)((detours[b] & ~(3 << (2 * corner))) | k << (2 * corner));
+    }
+
+    void clearDetour(int x, int y) {
+        edges[(y >> 1) * blocksX + (x >> 1)] &= (Uint8)~(cornerBit(x, y) << 4);
+    }
+
+    // Take the consecutive cells c -> d off the tour, joining the cells
+    // before and after them directly. Their blocks go back on the pending
+    // list, as their free cells may pair up again.
+    void cutPair(int c, int d) {
+        const int p = previous(c);
+        setDetour(p % width, p / width, stepBetween(p, next(d)));
+        const int cells[2] = {c, d};
+        for (int e : cells) {
+            clearDetour(e % width, e / width);
+            const int b = blockOf(e);
+            onTour[b] &= ~cornerBit(e % width, e / width);
+            pending.push_back(b);
+        }
+    }
+
+    // Splice the free cells of block b into the tour, each paired with a
+    // free neighbour (in this block or the next) where the tour runs
+    // alongside the two. True if any went in.
+    bool spliceBlock(int b, int bx, int by) {
+        bool spliced = false;
+        for (int k = 0; k < 4; k++) {
+            if ((walled[b] | onTour[b]) & (1 << k)) {
+                continue;
+            }
+            const int ax = bx * 2 + (k & 1);
+            const int ay = by * 2 + (k >> 1);
+            for (int along = 0; along < 4; along++) {
+                int cx = ax;
+                int cy = ay;
+                stepCell(cx, cy, along);
+                if (cellOpen(cx, cy) && splicePair(ax, ay, cx, cy, along)) {
+                    spliced = true;
+                    break;
+                }
+            }
+        }
+        return spliced;
+    }
+
+    // Splice the pair a -> c, one step `along` apart, into the tour if the
+    // tour steps between the two cells one step across from them.
+    bool splicePair(int ax, int ay, int cx, int cy, int along) {
+        for (int side = 0; side < 2; side++) {
+            const int across = (along < 2) ? 2 + side : side;   // from the pair outwards
+            int ux = ax;
+            int uy = ay;
+            stepCell(ux, uy, across);
+            int vx = cx;
+            int vy = cy;
+            stepCell(vx, vy, across);
+            if (!cellOnTour(ux, uy) || !cellOnTour(vx, vy)) {
+                continue;
+            }
+            int nx = ux;
+            int ny = uy;
+            advance(nx, ny);
+            const int inwards = OPPOSITE[across];
+            if (nx == vx && ny == vy) {
+                setDetour(ux, uy, inwards);
+                setDetour(ax, ay, along);
+                setDetour(cx, cy, across);
+            } else {
+                nx = vx;
+                ny = vy;
+                advance(nx, ny);
+                if (nx != ux || ny != uy) {
+                    continue;
+                }
+                setDetour(vx, vy, inwards);
+                setDetour(cx, cy, OPPOSITE[along]);
+                setDetour(ax, ay, across);
+            }
+            onTour[(ay >> 1) * blocksX + (ax >> 1)] |= cornerBit(ax, ay);
+            onTour[(cy >> 1) * blocksX + (cx >> 1)] |= cornerBit(cx, cy);
+            return true;
+        }
+        return false;
+    }
+
+    // Splice in the pending blocks. A splice gives the cells around it
+    // somewhere to go, so the block and those around it are tried again.
+    void spliceAll() {
+        for (size_t i = 0; i < pending.size(); i++) {
+            const int b  = pending[i];
+            const int bx = b % blocksX;
+            const int by = b / blocksX;
+            if (!spliceBlock(b, bx, by)) {
+                continue;
+            }
+            for (int k = 0; k < 5; k++) {
+                int nx = bx;
+                int ny = by;
+                if (k < 4) {
+                    stepBlock(nx, ny, k);
+                }
+                const int n = ny * blocksX + nx;
+                if ((walled[n] | onTour[n]) != 0xF) {
+                    pending.push_back(n);
+                }
+            }
+        }
+        pending.clear();
+    }
+
+    // Move (x, y) one step along the tour: by its detour if it has one,
+    // else round its block and out along the tree edges. Kept free of
+    // divisions since relabel() calls it once per tour cell.
+    void advance(int& x, int& y) const {
+        const int b = (y >> 1) * blocksX + (x >> 1);
+        Uint8 e = edges[b];
+        bool left = (x & 1) == 0;
+        bool top  = (y & 1) == 0;
+        if (e & (cornerBit(x, y) << 4)) {
+            stepCell(x, y, (detours[b] >> (2 * ((x & 1) | (y & 1) << 1))) & 3);
+            return;
+        }
+        if (top && left) {
+            (e & EDGE_WEST) ? x-- : y++;
+        } else if (!top && left) {
+            (e & EDGE_SOUTH) ? y++ : x++;
+        } else if (!top && !left) {
+            (e & EDGE_EAST) ? x++ : y--;
+        } else {
+            (e & EDGE_NORTH) ? y-- : x--;
+        }
+        if (x < 0) {
+            x = width - 1;
+        } else if (x == width) {
+            x = 0;
+        }
+        if (y < 0) {
+            y = height - 1;
+        } else if (y == height) {
+            y = 0;
+        }
+    }
+
+    // Walk the tour once and number its cells.
+    void relabel() {
+        // Cells on the tour are all numbered below; only the others need
+        // clearing.
+        for (int by = 0, b = 0; by < blocksY; by++) {
+            for (int bx = 0; bx < blocksX; bx++, b++) {
+                const int off = ~onTour[b] & 0xF;
+                for (int k = 0; off && k < 4; k++) {
+                    if (off & (1 << k)) {
+                        order[(by * 2 + (k >> 1)) * width + bx * 2 + (k & 1)] = -1;
+                    }
+                }
+            }
+        }
+        length = 0;
+        int start = -1;
+        for (int b = 0; b < blocksX * blocksY && start < 0; b++) {
+            if (onTour[b]) {
+                start = b;
+            }
+        }
+        if (start < 0) {
+            return;
+        }
+        int corner = 0;
+        while (!(onTour[start] & (1 << corner))) {
+            corner++;
+        }
+        const int x0 = (start % blocksX) * 2 + (corner & 1);
+        const int y0 = (start / blocksX) * 2 + (corner >> 1);
+        int x = x0;
+        int y = y0;
+        do {
+            order[y * width + x] = length++;
+            advance(x, y);
+        } while (x != x0 || y != y0);
+    }
+};
+
+//-------------------------------------------------------
+//                 HAMILTONIAN AUTOPILOT
+//-------------------------------------------------------
+// Perfect-play bot: follows the Hamiltonian tour, which can never run into
+// its own body, and takes shortcuts towards food that skip only empty
+// stretches of the tour. While the body is not laid out along the tour
+// (at the start of a game, or after new obstacles forced a rebuild) it
+// hands over to the BFS autopilot until the body lines up again.
+//
+// Every meal adds obstacles, so a long game still ends: once they cover
+// a fifth or so of the board the tour only spans the head's corner of it,
+// the BFS pilot does the steering, and sooner or later the snake gets
+// boxed in. The faster this pilot eats, the sooner that comes.
+class HamiltonPilot {
+public:
+    HamiltonPilot()
+        : cycle(GRID_COLS, GRID_ROWS),
+          wall(GRID_COLS * GRID_ROWS, 0),
+          layout(0),
+          valid(false)
+    {
+    }
+
+    // Pick the direction for the next tick of the given world.
+    Point chooseDirection(const GameWorld& world) {
+        if (world.snake.empty()) {
+            return world.direction;
+        }
+        sync(world);
+        if (!aligned(world)) {
+            return fallback.chooseDirection(world);
+        }
+
+        const int L    = cycle.size();
+        const int head = cellIndex(world.snake.front());
+        const int tail = cellIndex(world.snake.back());
+        const int len  = (int)world.snake.size();
+
+        // Target: the food that comes up soonest along the tour.
+        int target = -1;
+        int targetDist = L;
+        for (const auto& f : world.foodItems) {
+            int c = cellIndex(f);
+            if (cycle.contains(c)) {
+                int d = cycle.forwardDistance(head, c);
+                if (d < targetDist) {
+                    targetDist = d;
+                    target = c;
+                }
+            }
+        }
+
+        // Default: the next cell of the tour. It is normally free, but if
+        // anything sits there, let the BFS pilot find a safe move instead.
+        int best = cycle.next(head);
+        if (world.cells[best] & (CELL_SNAKE | CELL_OBSTACLE)) {
+            return fallback.chooseDirection(world);
+        }
+        if (target >= 0 && len < L / 2) {
+            // A shortcut may jump ahead along the tour as long as it lands
+            // before the food and keeps enough empty tour between the head
+            // and the tail to grow into.
+            int headRel  = cycle.forwardDistance(tail, head);
+            int bestDist = cycle.forwardDistance(best, target);
+            for (int k = 0; k < 4; k++) {
+                int n = neighbourCell(head, k);
+                if (!cycle.contains(n) ||
+                    (world.cells[n] & (CELL_SNAKE | CELL_OBSTACLE))) {
+                    continue;
+                }
+                int rel = cycle.forwardDistance(tail, n);
+                if (rel <= headRel || rel > cycle.forwardDistance(tail, target) ||
+                    L - rel < SHORTCUT_SLACK) {
+                    continue;
+                }
+                int dist = cycle.forwardDistance(n, target);
+                if (dist < bestDist) {
+                    bestDist = dist;
+                    best = n;
+                }
+            }
+        }
+        for (int k = 0; k < 4; k++) {
+            if (neighbourCell(head, k) == best) {
+                return DIRECTIONS[k];
+            }
+        }
+        return world.direction;
+    }
+
+private:
+    // Empty tour cells to keep ahead of the head when cutting corners.
+    static const int SHORTCUT_SLACK = 8;
+
+    HamiltonCycle      cycle;
+    std::vector<Uint8> wall;
+    Autopilot          fallback;
+    Uint32             layout;
+    std::vector<int>   seenCells;    // world.obstacles as cells at the last sync
+    bool               valid;
+
+    // Follow obstacle changes. After a meal the world only appends new
+    // obstacles, so each one either misses the tour, cuts off a leaf block,
+    // or forces a rebuild. Anything else (a reset puts the same number of
+    // obstacles in new cells, an undo drops some) shows up as the known
+    // cells no longer leading the list, and always rebuilds.
+    void sync(const GameWorld& world) {
+        if (valid && layout == world.layoutVersion) {
+            return;
+        }
+        const size_t seen = seenCells.size();
+        bool rebuild = !valid || world.obstacles.size() < seen;
+        for (size_t i = 0; i < seen && !rebuild; i++) {
+            rebuild = cellIndex(world.obstacles[i]) != seenCells[i];
+        }
+        for (size_t i = seen; i < world.obstacles.size() && !rebuild; i++) {
+            int c = cellIndex(world.obstacles[i]);
+            wall[c] = 1;
+            rebuild = !cycle.removeCell(c);
+        }
+        if (rebuild) {
+            std::fill(wall.begin(), wall.end(), 0);
+            for (const auto& obs : world.obstacles) {
+                wall[cellIndex(obs)] = 1;
+            }
+            cycle.build(wall, cellIndex(world.snake.front()));
+        }
+        layout = world.layoutVersion;
+        seenCells.clear();
+        for (const auto& obs : world.obstacles) {
+            seenCells.push_back(cellIndex(obs));
+        }
+        valid = true;
+    }
+
+    // The body lies along the tour when every segment is on it and the
+    // segments appear in tour order from tail to head.
+    bool aligned(const GameWorld& world) const {
+        const auto& snake = world.snake;
+        int tail = cellIndex(snake.back());
+        if (!cycle.contains(tail)) {
+            return false;
+        }
+        int prev = 0;
+        for (int i = (int)snake.size() - 2; i >= 0; i--) {
+            int c = cellIndex(snake[i]);
+            if (!cycle.contains(c)) {
+                return false;
+            }
+            int rel = cycle.forwardDistance(tail, c);
+            if (rel <= prev) {
+                return false;
+            }
+            prev = rel;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <vector>
+
+#include "game_world.h"
+
+// Turns held for the coming ticks. Enough for a quick double turn (a
+// U-turn one lane over) plus one more; anything beyond is dropped.
+const int INPUT_TURN_BUFFER = 3;
+
+// Input-to-move latencies kept for reporting.
+const int INPUT_LATENCY_SAMPLES = 4096;
+
+// A direction key, stamped with SDL_GetPerformanceCounter() when the
+// render thread saw it.
+struct TurnInput {
+    Point  direction;
+    Uint64 at;
+};
+
+//-------------------------------------------------------
+//                      TURN QUEUE
+//-------------------------------------------------------
+// Buffers turns so each tick applies at most one, in the order pressed.
+// A turn is checked against the direction the snake will have when its
+// turn comes (the last queued one), so two quick presses within one tick
+// both land, on consecutive ticks, instead of the second overwriting the
+// first or being judged against a stale direction.
+class TurnQueue {
+public:
+    TurnQueue()
+        : count(0),
+          queued(0),
+          dropped(0),
+          applied(0),
+          latencyCount(0)
+    {
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // Queue a turn given the snake's current direction. Returns false if
+    // it was dropped: full, not a quarter turn, or a repeat.
+    bool push(const TurnInput& t, Point current) {
+        Point last = count > 0 ? turns[count - 1].direction : current;
+        if (count == INPUT_TURN_BUFFER || !isQuarterTurn(last, t.direction)) {
+            dropped++;
+            return false;
+        }
+        turns[count++] = t;
+        queued++;
+        return true;
+    }
+
+    // At a tick boundary: the next turn that is still legal from current.
+    // Turns that no longer are (the snake was reset, say) are discarded.
+    bool pop(Point current, TurnInput& out) {
+        while (count > 0) {
+            TurnInput t = turns[0];
+            for (int i = 1; i < count; i++) {
+                turns[i - 1] = turns[i];
+            }
+            count--;
+            if (isQuarterTurn(current, t.direction)) {
+                out = t;
+                return true;
+            }
+            dropped++;
+        }
+        return false;
+    }
+
+    // Note when a popped turn reached the world.
+    void recordApplied(const TurnInput& t, Uint64 now) {
+        applied++;
+        latencyMs[latencyCount++ % INPUT_LATENCY_SAMPLES] =
+            1000.0 * (double)(now - t.at) / (double)SDL_GetPerformanceFrequency();
+    }
+
+    Uint64 queuedCount() const  { return queued; }
+    Uint64 droppedCount() const { return dropped; }
+    Uint64 appliedCount() const { return applied; }
+
+    // The most recent INPUT_LATENCY_SAMPLES key-to-move times, in ms.
+    std::vector<double> latencies() const {
+        size_t n = latencyCount < (Uint64)INPUT_LATENCY_SAMPLES ? (size_t)latencyCount
+                                                                : (size_t)INPUT_LATENCY_SAMPLES;
+        return std::vector<double>(latencyMs, latencyMs + n);
+    }
+
+private:
+    TurnInput turns[INPUT_TURN_BUFFER];
+    int       count;
+    Uint64    queued;
+    Uint64    dropped;
+    Uint64    applied;
+    Uint64    latencyCount;
+    double    latencyMs[INPUT_LATENCY_SAMPLES];
+
+    static bool isQuarterTurn(Point from, Point to) {
+        return from.x != 0 ? (to.x == 0 && to.y != 0) : (to.y == 0 && to.x != 0);
+    }
+};
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LIGHT_MAP_SSE2 1
+#endif
+
+// A light on a grid cell. It gives intensity * (1 - d^2 / radius^2) to a
+// cell d cells from its own, nothing from radius on; cells add up the
+// light they get and anything over 1 is full light.
+struct Light {
+    int   x, y;           // cell
+    float radius;         // in cells
+    float intensity;
+};
+
+//-------------------------------------------------------
+//                      LIGHT MAP
+//-------------------------------------------------------
+// How much light each cell of a board gets from a set of lights, as a
+// level from 0 (dark) to 255. Each light adds itself to the rows it
+// reaches, four cells at a time; finish() turns the sums into levels.
+class LightMap {
+public:
+    LightMap(int width, int height)
+        : width(width),
+          height(height),
+          sum(width * height, 0.0f),
+          level(width * height, 0)
+    {
+    }
+
+    int cols() const { return width; }
+    int rows() const { return height; }
+
+    // Start over in the dark.
+    void clear() {
+        std::fill(sum.begin(), sum.end(), 0.0f);
+    }
+
+    // Add a light. With a mask, only cells where it is nonzero get any,
+    // e.g. those a FieldOfView sees from the light.
+    void add(const Light& l, const Uint8* mask = nullptr) {
+        if (l.radius <= 0.0f || l.intensity <= 0.0f) {
+            return;
+        }
+        const float r2 = l.radius * l.radius;
+        const float k  = l.intensity / r2;
+        const int   r  = (int)l.radius;
+        const int   y0 = std::max(0, l.y - r);
+        const int   y1 = std::min(height - 1, l.y + r);
+        for (int y = y0; y <= y1; y++) {
+            const int dy = y - l.y;
+            const float rest = r2 - (float)(dy * dy);
+            if (rest <= 0.0f) {
+                continue;
+            }
+            const int half = (int)std::sqrt(rest);
+            const int x0 = std::max(0, l.x - half);
+            const int x1 = std::min(width - 1, l.x + half);
+            if (x0 > x1) {
+                continue;
+            }
+            const float base = l.intensity - (float)(dy * dy) * k;
+            float* row = &sum[(size_t)y * width];
+            if (mask) {
+                const Uint8* m = mask + (size_t)y * width;
+                for (int x = x0; x <= x1; x++) {
+                    if (m[x]) {
+                        float dx = (float)(x - l.x);
+                        row[x] += std::max(0.0f, base - dx * dx * k);
+                    }
+                }
+            } else {
+                addSpan(row + x0, x1 - x0 + 1, (float)(x0 - l.x), base, k);
+            }
+        }
+    }
+
+    // Turn the sums into levels.
+    void finish() {
+        const size_t n = sum.size();
+        size_t i = 0;
+#ifdef LIGHT_MAP_SSE2
+        const __m128 scale = _mm_set1_ps(255.0f);
+        const __m128 one   = _mm_set1_ps(1.0f);
+        const __m128 half  = _mm_set1_ps(0.5f);
+        for (; i + 16 <= n; i += 16) {
+            __m128i q[4];
+            for (int j = 0; j < 4; j++) {
+                __m128 v = _mm_min_ps(_mm_loadu_ps(&sum[i + 4 * j]), one);
+                q[j] = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, scale), half));
+            }
+            __m128i packed = _mm_packus_epi16(_mm_packs_epi32(q[0], q[1]),
+                                              _mm_packs_epi32(q[2], q[3]));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(&level[i]), packed);
+        }
+#endif
+        for (; i < n; i++) {
+            level[i] = (Uint8)(std::min(sum[i], 1.0f) * 255.0f + 0.5f);
+        }
+    }
+
+    // Levels after finish(), one per cell.
+    const std::vector<Uint8>& levels() const { return level; }
+
+private:
+    int width;
+    int height;
+    std::vector<float> sum;
+    std::vector<Uint8> level;
+
+    // dst[i] += max(0, base - (dx0 + i)^2 * k)
+    static void addSpan(float* dst, int n, float dx0, float base, float k) {
+        int i = 0;
+#ifdef LIGHT_MAP_SSE2
+        __m128 dx = _mm_add_ps(_mm_set1_ps(dx0), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+        const __m128 four = _mm_set1_ps(4.0f);
+        const __m128 b    = _mm_set1_ps(base);
+        const __m128 kk   = _mm_set1_ps(k);
+        const __m128 zero = _mm_setzero_ps();
+        for (; i + 4 <= n; i += 4) {
+            __m128 v = _mm_max_ps(_mm_sub_ps(b, _mm_mul_ps(_mm_mul_ps(dx, dx), kk)), zero);
+            _mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), v));
+            dx = _mm_add_ps(dx, four);
+        }
+#endif
+        for (; i < n; i++) {
+            float dx = dx0 + (float)i;
+            dst[i] += std::max(0.0f, base - dx * dx * k);
+        }
+    }
+};
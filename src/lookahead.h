@@ -0,0 +1,112 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <climits>
+#include <cstdlib>
+
+#include "game_world.h"
+
+//-------------------------------------------------------
+//                  LOOKAHEAD AUTOPILOT
+//-------------------------------------------------------
+// Exhaustive depth-limited search over the real game rules. The live world
+// is copied into a scratch world once per decision; from there every node
+// is one step() and one undo() on that copy, so expanding the tree never
+// allocates once the scratch vectors have grown.
+class LookaheadPilot {
+public:
+    static const int DEFAULT_DEPTH = 8;
+
+    LookaheadPilot()
+        : depth(DEFAULT_DEPTH),
+          nodes(0)
+    {
+        sim.recordUndo = true;
+        sim.undoLog.reserve(DEFAULT_DEPTH * 4);
+        sim.foodStash.reserve(DEFAULT_DEPTH * 64);
+    }
+
+    Uint64 nodeCount() const { return nodes; }
+
+    // Pick the direction for the next tick of the given world.
+    Point chooseDirection(const GameWorld& world) {
+        if (world.snake.empty()) {
+            return world.direction;
+        }
+        sim.copyStateFrom(world);
+
+        Point     bestDir   = world.direction;
+        long long bestValue = LLONG_MIN;
+        for (int k = 0; k < 4; k++) {
+            long long value = expand(DIRECTIONS[k], depth);
+            if (value > bestValue) {
+                bestValue = value;
+                bestDir   = DIRECTIONS[k];
+            }
+        }
+        return bestDir;
+    }
+
+private:
+    // Dying is worth less than anything else, but dying later beats dying
+    // sooner.
+    static const long long DEATH      = -1000000000LL;
+    static const long long PER_POINT  = 100000;
+    static const long long PER_STEP   = 100;
+
+    GameWorld sim;
+    int       depth;
+    Uint64    nodes;
+
+    // Value of moving in dir from the current sim state, searching
+    // depthLeft plies in total.
+    long long expand(Point dir, int depthLeft) {
+        // Turning back onto the neck is always fatal; skip the node.
+        if (sim.snake.size() > 1 &&
+            dir.x == -sim.direction.x && dir.y == -sim.direction.y) {
+            return LLONG_MIN;
+        }
+        nodes++;
+        const Point incoming = sim.direction;
+        sim.direction = dir;
+        TickEvent ev = sim.step();
+
+        long long value;
+        if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+            value = DEATH - depthLeft * PER_POINT;
+        } else if (depthLeft <= 1) {
+            value = evaluate();
+        } else {
+            value = LLONG_MIN;
+            for (int k = 0; k < 4; k++) {
+                value = std::max(value, expand(DIRECTIONS[k], depthLeft - 1));
+            }
+        }
+        sim.undo();
+        // undo() restores the direction the step ran with; put back the
+        // one the parent arrived with for the next sibling.
+        sim.direction = incoming;
+        return value;
+    }
+
+    // Leaf score: points banked, then closeness to food, then room to move.
+    long long evaluate() const {
+        const Point head = sim.snake.front();
+        int nearest = GRID_COLS + GRID_ROWS;
+        for (const auto& f : sim.foodItems) {
+            int dx = std::abs(f.x - head.x) / GRID_SIZE;
+            int dy = std::abs(f.y - head.y) / GRID_SIZE;
+            dx = std::min(dx, GRID_COLS - dx);
+            dy = std::min(dy, GRID_ROWS - dy);
+            nearest = std::min(nearest, dx + dy);
+        }
+        int freeNeighbours = 0;
+        const int h = cellIndex(head);
+        for (int k = 0; k < 4; k++) {
+            if (!(sim.cells[neighbourCell(h, k)] & (CELL_SNAKE | CELL_OBSTACLE))) {
+                freeNeighbours++;
+            }
+        }
+        return sim.score * PER_POINT - nearest * PER_STEP + freeNeighbours;
+    }
+};
@@ -3,19 +3,25 @@
 #include <SDL2/SDL_mixer.h>
 #include <cmath>
 #include <vector>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
 #include <iostream>
 #include <string>
+#include <chrono>
+
+#include "game_world.h"
+#include "assets.h"
+#include "simulation.h"
+#include "text_cache.h"
+#include "quality.h"
+#include "canvas.h"
+#include "bench.h"
 
 //-------------------------------------------------------
 //                       CONSTANTS
 //-------------------------------------------------------
-const int SCREEN_WIDTH       = 800;
-const int SCREEN_HEIGHT      = 600;
-const int GRID_SIZE          = 20;
-
 // Default snake speed (ms per movement).
 const int DEFAULT_SNAKE_SPEED = 100;
 
@@ -23,8 +29,38 @@ const int DEFAULT_SNAKE_SPEED = 100;
 const float DEFAULT_GRASS_WAVE_SPEED     = 0.05f;  
 const float DEFAULT_GRASS_WAVE_AMPLITUDE = 15.0f; 
 
-// Flashlight game mode: how many grid blocks from snake head are visible.
-const int FLASHLIGHT_RADIUS_BLOCKS = 5;
+// Grass animation clock, per millisecond of wall time. The same 0.02 a
+// frame the loop used to add at its ~1ms pace, now independent of how
+// often we draw.
+const float GRASS_ANIMATION_PER_MS = 0.02f;
+
+// Frame rate of the grass on the menus and the pause screen, where we
+// sleep between frames instead of spinning. The software backend redraws
+// the whole frame on the CPU, so it gets a lower rate to keep an idle
+// menu under 2% of a core. --menu-fps sets either; 0 holds the grass
+// still, so those screens are only drawn again when something on them
+// changes.
+const int DEFAULT_MENU_FPS  = 30;
+const int SOFTWARE_MENU_FPS = 12;
+const int MIN_MENU_FPS      = 0;
+const int MAX_MENU_FPS      = 240;
+
+// How often an idle screen with still grass wakes anyway, to pick up a
+// snapshot the simulation published after the last event.
+const Uint32 IDLE_WAKE_MS  = 250;
+
+// Taken during static initialisation, as close to process start as we can
+// get, so the startup report covers the whole cold start.
+const std::chrono::steady_clock::time_point PROCESS_START = std::chrono::steady_clock::now();
+
+// Rewind history is configured in steps of this many ticks.
+const int REWIND_CONFIG_STEP = 1000;
+
+// Entries in the game mode menu, one per GameMode in order.
+const int MODE_COUNT = 3;
+
+// The F3 overlay's numbers are refreshed this often, so they can be read.
+const Uint32 OVERLAY_REFRESH_MS = 250;
 
 // Enumeration of possible game states.
 enum class GameState {
@@ -43,53 +79,43 @@ enum class ConfigOption {
     NUM_OBSTACLES,
     AMPLITUDE,
     WAVE_SPEED,
+    REWIND,
+    QUALITY,
     EXIT
 };
 
-// Enumeration for game modes.
-enum class GameMode {
-    NORMAL,
-    FLASHLIGHT
-};
-
-struct Point {
-    int x;
-    int y;
-    bool operator==(const Point& other) const {
-        return x == other.x && y == other.y;
-    }
-};
-
-struct GrassBlade {
-    float x;
-    float y;
-    float height;
-    float waveOffset;
-    float randomAmplitude; // Varied amplitude for each blade
-};
-
-struct Sparkle {
-    float x, y;
-    float life;
-};
-
 class Application {
 public:
-    Application() 
+    explicit Application(const AudioConfig& audioConfig = AudioConfig(),
+                         RenderBackend backend = RenderBackend::AUTO,
+                         bool vsync = true)
         : window(nullptr),
           renderer(nullptr),
+          vsynced(false),
           font(nullptr),
           scoreFont(nullptr),
-          collisionSound(nullptr),
-          eatsound(nullptr),
           state(GameState::MAIN_MENU),
           gameMode(GameMode::NORMAL),
-          direction({1, 0}),
-          lastMoveTime(0),
           running(true),
-          score(0),
-          highScore(0),
+          pilotMode(PilotMode::OFF),
+          replaying(false),
+          rewinding(false),
+          seenPlaybacks(0),
+          assetsReady(false),
+          reportStartup(false),
           animationTime(0.0f),
+          animationStart(0),
+          menuFps(DEFAULT_MENU_FPS),
+          nextMenuFrame(0),
+          lastUpdate(0),
+          sceneDirty(true),
+          fogAlphas(GRID_COLS * GRID_ROWS, 255),
+          fogSequence(0),
+          fogSoftness(-1),
+          showOverlay(false),
+          overlayUpdated(0),
+          overlayFrames(0),
+          overlayWorkMs(0.0),
           selectedOption(0),
           pauseMenuOption(0),
           configOption(0),
@@ -97,12 +123,21 @@ public:
           snakeSpeed(DEFAULT_SNAKE_SPEED),
           numFoodItems(10),
           numObstacles(15),
+          rewindTicks((int)DEFAULT_REWIND_TICKS),
           grassWaveSpeed(DEFAULT_GRASS_WAVE_SPEED),
           grassWaveAmplitude(DEFAULT_GRASS_WAVE_AMPLITUDE)
     {
-        SDL_Init(SDL_INIT_VIDEO);
+        // Audio is initialised here as well, so that Mix_OpenAudio on the
+        // asset loader only opens the device: SDL's subsystems must not be
+        // initialised from two threads at once.
+        SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO);
         TTF_Init();
-        Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048);
+        startup.initMs = millisSince(PROCESS_START);
+
+        // Fonts, sounds (and the audio device) and the grass are loaded on a
+        // worker; menus draw with placeholders until they arrive.
+        assetLoader.start(((Uint64)std::time(nullptr) << 32) ^ SDL_GetPerformanceCounter(),
+                          &audio, audioConfig);
 
         window = SDL_CreateWindow(
             "Snake + Procedural Grass + Flashlight Mode",
@@ -113,18 +148,35 @@ public:
             SDL_WINDOW_SHOWN
         );
 
-        // Use accelerated rendering if available.
-        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
-        font      = TTF_OpenFont("COMIC.TTF", 24);
-        scoreFont = TTF_OpenFont("COMIC.TTF", 28);
-        collisionSound = Mix_LoadWAV("colision.wav"); // Provide your .wav file
-        eatsound = Mix_LoadWAV("eat.wav"); // Provide your .wav file
+        // Use accelerated rendering if available, presenting in step with
+        // the display unless asked not to.
+        renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED |
+                                      (vsync ? SDL_RENDERER_PRESENTVSYNC : 0));
+        SDL_RendererInfo info;
+        vsynced = renderer && SDL_GetRendererInfo(renderer, &info) == 0 &&
+                  (info.flags & SDL_RENDERER_PRESENTVSYNC);
+        if (canvas.init(renderer, SCREEN_WIDTH, SCREEN_HEIGHT, backend) == RenderBackend::SOFTWARE) {
+            menuFps = SOFTWARE_MENU_FPS;
+        }
+        texts.setRenderer(renderer);
+        animationStart = SDL_GetTicks();
+        startup.windowMs = millisSince(PROCESS_START);
 
-        std::srand(static_cast<unsigned>(std::time(nullptr)));
-        generateGrass();
+        sim.setAudio(&audio);
+        if (!sim.openStats(STATS_DIR)) {
+            std::cerr << "Could not open the stats store in " << STATS_DIR << "\n";
+        }
     }
 
     ~Application() {
+        // Let a load still in flight finish so its handles get freed below.
+        LoadedAssets late;
+        if (assetLoader.finish(late)) {
+            adoptAssets(late);
+        }
+        sim.stop();
+        texts.clear();
+        canvas.release();
         if (scoreFont) {
             TTF_CloseFont(scoreFont);
             scoreFont = nullptr;
@@ -141,25 +193,76 @@ public:
             SDL_DestroyWindow(window);
             window = nullptr;
         }
-        if (collisionSound) {
-            Mix_FreeChunk(collisionSound);
-        }
-        if (eatsound) {
-            Mix_FreeChunk(eatsound);
-        }
-        Mix_CloseAudio();
+        audio.close();
         TTF_Quit();
         SDL_Quit();
     }
 
-    // Main application loop.
+    // Play a recorded session in the window. Returns false if the file
+    // is not a replay this build can read.
+    // Call before run().
+    bool startReplay(const std::string& path) {
+        if (!sim.loadReplay(path)) {
+            return false;
+        }
+        gameMode  = sim.replayMode();
+        replaying = true;
+        state     = GameState::PLAYING;
+        return true;
+    }
+
+    // Skip the menus and let the autopilot play, for soak tests and demos.
+    void startAutopilot(PilotMode mode) {
+        pilotMode = mode;
+        startGame();
+    }
+
+    // Print where the startup time went once the assets are in.
+    void setStartupReport(bool enabled) {
+        reportStartup = enabled;
+    }
+
+    // Threads for the software backend's tiles; 0 is one per core.
+    void setRasterThreads(unsigned count) {
+        canvas.setRasterThreads(count);
+    }
+
+    // Frame time the quality governor tries to hold.
+    void setFrameBudget(double ms) {
+        quality.setBudgetMs(ms);
+    }
+
+    // Frames per second of the grass on the menus and the pause screen;
+    // 0 holds it still.
+    void setMenuFrameRate(int fps) {
+        menuFps = std::max(MIN_MENU_FPS, std::min(fps, MAX_MENU_FPS));
+    }
+
+    // Main application loop: input and drawing. The game itself ticks on
+    // the simulation thread. On the menus and the pause screen we block
+    // until an event arrives or the next menu frame is due, and only draw
+    // when something on screen changed. In play every frame is drawn, as
+    // the snake moves between ticks; vsync paces them to the display.
     void run() {
+        sim.start();
         while (running && state != GameState::QUIT) {
-            handleEvents();
+            pollAssets();
+            if (idle()) {
+                waitForEvents();
+            } else {
+                handleEvents();
+            }
+            Uint64 frameStart = SDL_GetPerformanceCounter();
             update();
-            render();
-            SDL_Delay(1); 
+            if (!idle() || sceneDirty) {
+                Uint64 drawn = render();
+                frameDone(frameStart, drawn);
+            }
+            if (!idle() && !vsynced) {
+                SDL_Delay(1);
+            }
         }
+        sim.stop();
     }
 
 private:
@@ -168,10 +271,11 @@ private:
     //---------------------------------------------------
     SDL_Window*   window;
     SDL_Renderer* renderer;
+    bool          vsynced;     // present() waits for the display
+    Canvas        canvas;      // all drawing goes through here
     TTF_Font*     font;
     TTF_Font*     scoreFont;
-    Mix_Chunk*    collisionSound;
-    Mix_Chunk*    eatsound;
+    AudioSystem   audio;
 
     GameState state;
     GameMode  gameMode;
@@ -180,20 +284,71 @@ private:
     //---------------------------------------------------
     //               SNAKE & GAMEPLAY VARIABLES
     //---------------------------------------------------
-    std::vector<Point> snake;
-    std::vector<Point> foodItems;
-    std::vector<Point> obstacles;  
-    Point  direction;
-    Uint32 lastMoveTime;
-    int    score;
-    int    highScore;
+    // The game runs here; we send it input and draw its snapshots.
+    Simulation sim;
+
+    // Computer players; TAB cycles through them while playing.
+    PilotMode  pilotMode;
+
+    // Playing back a recording rather than a live game.
+    bool       replaying;
+
+    // Hold R to step the live game backwards.
+    bool       rewinding;
+
+    // Playbacks seen to finish, to notice the next one.
+    Uint32     seenPlaybacks;
+
+    //---------------------------------------------------
+    //              ASSETS & STARTUP TIMING
+    //---------------------------------------------------
+    // Milliseconds since PROCESS_START at each startup milestone.
+    struct StartupTimes {
+        double initMs;
+        double windowMs;
+        double firstFrameMs;
+        double assetsMs;
+    };
+
+    AssetLoader  assetLoader;
+    bool         assetsReady;
+    bool         reportStartup;
+    StartupTimes startup = {0.0, 0.0, -1.0, -1.0};
 
     //---------------------------------------------------
     //           PROCEDURAL GRASS & TIMING
     //---------------------------------------------------
-    float animationTime;
+    float  animationTime;
+    Uint32 animationStart;     // SDL_GetTicks() at zero animationTime
     std::vector<GrassBlade> grassBlades;
-    std::vector<Sparkle> sparkles;
+    std::vector<SDL_Point>  grassTips;    // where each blade's tip is drawn
+
+    //---------------------------------------------------
+    //           IDLE FRAMES & TEXT
+    //---------------------------------------------------
+    int    menuFps;
+    Uint32 nextMenuFrame;      // SDL_GetTicks() when the next menu frame is due
+    Uint32 lastUpdate;         // SDL_GetTicks() at the last update()
+    bool   sceneDirty;         // something drawn changed since the last present
+    TextCache texts;
+
+    //---------------------------------------------------
+    //           LIGHT MODES
+    //---------------------------------------------------
+    std::vector<Uint8> fogAlphas;      // darkness per cell
+    Uint64             fogSequence;    // snapshot fogAlphas was made from
+    int                fogSoftness;
+    std::vector<SDL_Rect> litRuns;     // runs of lit cells this frame, in pixels
+
+    //---------------------------------------------------
+    //           QUALITY & PROFILER OVERLAY
+    //---------------------------------------------------
+    QualityGovernor quality;
+    bool        showOverlay;       // F3
+    std::string overlayText;
+    Uint32      overlayUpdated;    // SDL_GetTicks() of the last refresh
+    int         overlayFrames;     // frames and their work since then
+    double      overlayWorkMs;
 
     //---------------------------------------------------
     //           MENU & CONFIG VARIABLES
@@ -207,6 +362,7 @@ private:
     int   snakeSpeed;          // Lower value => faster snake
     int   numFoodItems;
     int   numObstacles;
+    int   rewindTicks;         // rewind history length, 0 = off
     float grassWaveSpeed;
     float grassWaveAmplitude;
 
@@ -216,22 +372,55 @@ private:
     void handleEvents() {
         SDL_Event event;
         while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_QUIT) {
-                running = false;
-                state   = GameState::QUIT;
-            } else if (event.type == SDL_KEYDOWN) {
-                onKeyDown(event.key.keysym.sym);
+            dispatch(event);
+        }
+    }
+
+    // Sleep until an event arrives or the next menu frame is due, then
+    // take whatever else is queued.
+    void waitForEvents() {
+        int timeout = (int)(nextMenuFrame - SDL_GetTicks());
+        SDL_Event event;
+        if (timeout > 0 && SDL_WaitEventTimeout(&event, timeout)) {
+            dispatch(event);
+        }
+        handleEvents();
+    }
+
+    void dispatch(const SDL_Event& event) {
+        // Keys move selections and window events may need a redraw;
+        // assume anything can change the picture.
+        sceneDirty = true;
+        if (event.type == SDL_QUIT) {
+            running = false;
+            state   = GameState::QUIT;
+        } else if (event.type == SDL_KEYDOWN) {
+            onKeyDown(event.key.keysym.sym);
+        } else if (event.type == SDL_KEYUP) {
+            if (event.key.keysym.sym == SDLK_r && rewinding) {
+                rewinding = false;
+                sim.send(SimCommandType::REWIND, 0);
             }
         }
     }
 
+    // Nothing moves on its own here but the grass.
+    bool idle() const {
+        return assetsReady && (state == GameState::MAIN_MENU ||
+                               state == GameState::CONFIG_MENU ||
+                               state == GameState::MODE_MENU ||
+                               state == GameState::PAUSED);
+    }
+
     void onKeyDown(SDL_Keycode key) {
         switch (key) {
             case SDLK_ESCAPE: {
                 if (state == GameState::PLAYING) {
                     state = GameState::PAUSED;
+                    sim.send(SimCommandType::PAUSE);
                 } else if (state == GameState::PAUSED) {
                     state = GameState::PLAYING;
+                    sim.send(SimCommandType::RESUME);
                 } else if (state == GameState::CONFIG_MENU || 
                            state == GameState::MODE_MENU) {
                     state = GameState::MAIN_MENU;
@@ -243,8 +432,8 @@ private:
                 if (state == GameState::MAIN_MENU) {
                     // Suppose we have 4 items. We cycle upward
                     selectedOption = (selectedOption + 3) % 4; 
-                } else if (state == GameState::PLAYING && direction.y == 0) {
-                    direction = {0, -1};
+                } else if (state == GameState::PLAYING) {
+                    turn({0, -1});
                 } else if (state == GameState::PAUSED) {
                     pauseMenuOption = (pauseMenuOption == 0) ? 1 : 0;
                 } else if (state == GameState::CONFIG_MENU) {
@@ -252,50 +441,95 @@ private:
                         ? (int)ConfigOption::EXIT 
                         : configOption - 1;
                 } else if (state == GameState::MODE_MENU) {
-                    // Only 2 modes: cycle between them
-                    modeMenuOption = (modeMenuOption == 0) ? 1 : 0;
+                    modeMenuOption = (modeMenuOption + MODE_COUNT - 1) % MODE_COUNT;
                 }
                 break;
             case SDLK_DOWN:
             case SDLK_s:
                 if (state == GameState::MAIN_MENU) {
                     selectedOption = (selectedOption + 1) % 4;
-                } else if (state == GameState::PLAYING && direction.y == 0) {
-                    direction = {0, 1};
+                } else if (state == GameState::PLAYING) {
+                    turn({0, 1});
                 } else if (state == GameState::PAUSED) {
                     pauseMenuOption = (pauseMenuOption == 0) ? 1 : 0;
                 } else if (state == GameState::CONFIG_MENU) {
                     configOption = (configOption + 1) 
                         % ((int)ConfigOption::EXIT + 1);
                 } else if (state == GameState::MODE_MENU) {
-                    // Also just 2 modes, cycle
-                    modeMenuOption = (modeMenuOption == 0) ? 1 : 0;
+                    modeMenuOption = (modeMenuOption + 1) % MODE_COUNT;
                 }
                 break;
             case SDLK_LEFT:
             case SDLK_a:
-                if (state == GameState::PLAYING && direction.x == 0) {
-                    direction = {-1, 0};
+                if (state == GameState::PLAYING) {
+                    turn({-1, 0});
                 } else if (state == GameState::CONFIG_MENU) {
                     adjustConfigOption(false);
                 }
                 break;
             case SDLK_RIGHT:
             case SDLK_d:
-                if (state == GameState::PLAYING && direction.x == 0) {
-                    direction = {1, 0};
+                if (state == GameState::PLAYING) {
+                    turn({1, 0});
                 } else if (state == GameState::CONFIG_MENU) {
                     adjustConfigOption(true);
                 }
                 break;
+            case SDLK_r:
+                if (state == GameState::PLAYING && !replaying && !rewinding) {
+                    rewinding = true;
+                    sim.send(SimCommandType::REWIND, 1);
+                }
+                break;
+            case SDLK_TAB:
+                if (state == GameState::PLAYING) {
+                    pilotMode = (pilotMode == PilotMode::OFF)    ? PilotMode::SEARCH
+                              : (pilotMode == PilotMode::SEARCH) ? PilotMode::CYCLE
+                              : (pilotMode == PilotMode::CYCLE)  ? PilotMode::LOOKAHEAD
+                              : PilotMode::OFF;
+                    sim.send(SimCommand{SimCommandType::SET_PILOT, 0, {0, 0}, sessionConfig(), 0});
+                }
+                break;
+            case SDLK_PLUS:
+            case SDLK_EQUALS:
+            case SDLK_KP_PLUS:
+                if (replaying) {
+                    sim.send(SimCommandType::PLAYBACK_FASTER);
+                }
+                break;
+            case SDLK_MINUS:
+            case SDLK_KP_MINUS:
+                if (replaying) {
+                    sim.send(SimCommandType::PLAYBACK_SLOWER);
+                }
+                break;
+            case SDLK_PAGEUP:
+                if (replaying) {
+                    sim.send(SimCommandType::SEEK, (int)REPLAY_SEEK_TICKS);
+                }
+                break;
+            case SDLK_PAGEDOWN:
+                if (replaying) {
+                    sim.send(SimCommandType::SEEK, -(int)REPLAY_SEEK_TICKS);
+                }
+                break;
+            case SDLK_HOME:
+                if (replaying) {
+                    sim.send(SimCommandType::RESTART_REPLAY);
+                }
+                break;
+            case SDLK_F3:
+                showOverlay = !showOverlay;
+                break;
             case SDLK_RETURN:
                 if (state == GameState::MAIN_MENU) {
                     mainMenuSelection();
                 } else if (state == GameState::PAUSED) {
                     if (pauseMenuOption == 0) {
                         state = GameState::PLAYING; 
+                        sim.send(SimCommandType::RESUME);
                     } else {
-                        state = GameState::MAIN_MENU;
+                        leaveGame();
                     }
                 } else if (state == GameState::MODE_MENU) {
                     modeSelection();
@@ -365,6 +599,18 @@ private:
                 if (increase) grassWaveSpeed += 0.01f;
                 else grassWaveSpeed = std::max(0.0f, grassWaveSpeed - 0.01f);
                 break;
+            case ConfigOption::REWIND:
+                if (increase) rewindTicks += REWIND_CONFIG_STEP;
+                else rewindTicks = std::max(0, rewindTicks - REWIND_CONFIG_STEP);
+                break;
+            case ConfigOption::QUALITY: {
+                // AUTO, LOW, MEDIUM, HIGH, around again.
+                int mode = quality.mode();
+                if (increase) mode = (mode == QUALITY_LEVEL_COUNT - 1) ? QUALITY_AUTO : mode + 1;
+                else mode = (mode == QUALITY_AUTO) ? QUALITY_LEVEL_COUNT - 1 : mode - 1;
+                quality.setMode(mode);
+                break;
+            }
             case ConfigOption::EXIT:
                 // Exit config menu
                 state = GameState::MAIN_MENU;
@@ -376,12 +622,8 @@ private:
     //                GAME MODE MENU
     //---------------------------------------------------
     void modeSelection() {
-        // 0 -> NORMAL, 1 -> FLASHLIGHT
-        if (modeMenuOption == 0) {
-            gameMode = GameMode::NORMAL;
-        } else {
-            gameMode = GameMode::FLASHLIGHT;
-        }
+        // 0 -> NORMAL, 1 -> FLASHLIGHT, 2 -> SHADOWS
+        gameMode = (GameMode)modeMenuOption;
         state = GameState::MAIN_MENU;
     }
 
@@ -389,109 +631,69 @@ private:
     //             GAME UPDATE & LOGIC
     //---------------------------------------------------
     void update() {
-        animationTime += 0.02f;
-
-        if (state != GameState::PLAYING) {
-            return;
+        // While idle the grass only moves once per menu frame, or not at
+        // all at a menu frame rate of 0. Then its clock stops as well, so
+        // it carries on from the same place afterwards.
+        Uint32 now = SDL_GetTicks();
+        if (idle() && menuFps == 0) {
+            animationStart += now - lastUpdate;
+            nextMenuFrame   = now + IDLE_WAKE_MS;
+        } else if (!idle() || (Sint32)(now - nextMenuFrame) >= 0) {
+            nextMenuFrame = now + 1000 / std::max(menuFps, 1);
+            animationTime = (float)(now - animationStart) * GRASS_ANIMATION_PER_MS;
+            updateGrassTips();
         }
-        Uint32 currentTime = SDL_GetTicks();
-        if (currentTime - lastMoveTime < (Uint32)snakeSpeed) {
+        lastUpdate = now;
+
+        if (!sim.refresh()) {
             return;
         }
-        lastMoveTime = currentTime;
-
-        if (!snake.empty()) {
-            Point newHead = {
-                snake[0].x + direction.x * GRID_SIZE,
-                snake[0].y + direction.y * GRID_SIZE
-            };
-
-            // Wrap horizontally
-            if (newHead.x < 0) {
-                newHead.x = SCREEN_WIDTH - GRID_SIZE;
-            } else if (newHead.x >= SCREEN_WIDTH) {
-                newHead.x = 0;
-            }
-
-            // Wrap vertically
-            if (newHead.y < 0) {
-                newHead.y = SCREEN_HEIGHT - GRID_SIZE;
-            } else if (newHead.y >= SCREEN_HEIGHT) {
-                newHead.y = 0;
-            }
-
-            // Collision with itself
-            for (const auto& segment : snake) {
-                if (newHead == segment) {
-                    handleCollision();
-                    return;
-                }
-            }
-
-            // Collision with obstacles
-            for (const auto& obs : obstacles) {
-                if (newHead == obs) {
-                    handleCollision();
-                    return;
-                }
-            }
-
-            // Insert new head
-            snake.insert(snake.begin(), newHead);
-
-            // Check for food collision
-            auto it = std::find(foodItems.begin(), foodItems.end(), newHead);
-            if (it != foodItems.end()) {
-                // Score up
-                score++;
-                if (score > highScore) {
-                    highScore = score;
-                }
-                Mix_PlayChannel(-1, eatsound, 0);
-                // Clear old food and spawn new set
-                foodItems.clear();
-                spawnFood();
-                spawnObstacles(5);
-            } else {
-                // Remove tail
-                snake.pop_back();
+        sceneDirty = true;
+        // A playback that ran to its end drops back to the menu.
+        const GameSnapshot& snap = sim.snapshot();
+        if (snap.finishedPlaybacks != seenPlaybacks) {
+            seenPlaybacks = snap.finishedPlaybacks;
+            if (replaying) {
+                leaveGame();
             }
         }
+    }
 
-        for (auto &sp : sparkles) {
-            sp.life -= 0.05f;
+    // Time the frame just drawn and let the governor react to it. The
+    // wait for vsync after drawn is not work, so it is left out.
+    void frameDone(Uint64 frameStart, Uint64 drawn) {
+        double ms = 1000.0 * (double)(drawn - frameStart) /
+                    (double)SDL_GetPerformanceFrequency();
+        int before = quality.level();
+        quality.frame(ms);
+        if (quality.level() != before) {
+            sceneDirty = true;
         }
-        sparkles.erase(std::remove_if(sparkles.begin(), sparkles.end(), 
-            [](const Sparkle &s){return s.life <= 0.f;}), sparkles.end());
+        overlayFrames++;
+        overlayWorkMs += ms;
     }
 
-    void handleCollision() {
-        if (collisionSound) {
-            Mix_PlayChannel(-1, collisionSound, 0);
-        }
-        for (int i = 0; i < 20; ++i) {
-            Sparkle sp;
-            sp.x = (float)snake[0].x + GRID_SIZE / 2;
-            sp.y = (float)snake[0].y + GRID_SIZE / 2;
-            sp.life = 1.0f;
-            sparkles.push_back(sp);
-        }
-        if (score > highScore) {
-            highScore = score;
-        }
-        resetGame();
+    // Queue a turn for the next free tick, stamped with when we saw it.
+    void turn(Point direction) {
+        sim.send(SimCommand{SimCommandType::TURN, 0, direction, sessionConfig(),
+                            SDL_GetPerformanceCounter()});
     }
 
     //---------------------------------------------------
     //                      RENDER
     //---------------------------------------------------
-    void render() {
+    // Returns SDL_GetPerformanceCounter() once the frame was drawn, before
+    // presenting it.
+    Uint64 render() {
         // Black background
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
+        canvas.setColor(0, 0, 0, 255);
+        canvas.clear();
+
+        // In the light modes only the cells the lights reach can show.
+        const std::vector<Uint8>* lit = lightView() ? &sim.snapshot().light : nullptr;
 
         // Grass first
-        renderGrass();
+        renderGrass(lit);
 
         // Render state
         switch (state) {
@@ -505,11 +707,11 @@ private:
                 renderModeMenu();
                 break;
             case GameState::PLAYING:
-                renderGame();
+                renderGame(lit);
                 renderScore();
                 break;
             case GameState::PAUSED:
-                renderGame();
+                renderGame(lit);
                 renderScore();
                 renderPauseMenu();
                 break;
@@ -517,138 +719,374 @@ private:
                 // do nothing
                 break;
         }
-        SDL_RenderPresent(renderer);
+        if (showOverlay) {
+            renderOverlay();
+        }
+        if (!assetsReady) {
+            renderLoadingBar();
+        }
+        canvas.finish();
+        Uint64 drawn = SDL_GetPerformanceCounter();
+        canvas.present();
+        texts.endFrame();
+        sceneDirty = false;
+        if (startup.firstFrameMs < 0.0) {
+            startup.firstFrameMs = millisSince(PROCESS_START);
+        }
+        return drawn;
+    }
+
+    // Whether a light mode's board is on screen. Then only cells with
+    // some light are drawn; the rest of the screen stays the black clear.
+    bool lightView() const {
+        if (gameMode == GameMode::NORMAL ||
+            (state != GameState::PLAYING && state != GameState::PAUSED)) {
+            return false;
+        }
+        return !sim.snapshot().light.empty();
     }
 
-    // Render the playing field (snake, obstacles, food).
-    void renderGame() {
+    // Render the playing field (snake, obstacles, food). With a light map
+    // (the light modes) only the lit cells are drawn, and the fog goes on
+    // top of them.
+    void renderGame(const std::vector<Uint8>* lit) {
+        const GameSnapshot& snap = sim.snapshot();
+        if (lit) {
+            renderLitBoard(*lit);
+            renderLitCells(snap);
+            renderFog(snap);
+            renderSparkles(snap);
+            return;
+        }
+
         // Draw grid lines for additional visual
-        SDL_SetRenderDrawColor(renderer, 50, 50, 50, 255);
+        canvas.setColor(50, 50, 50, 255);
         for (int x = 0; x < SCREEN_WIDTH; x += GRID_SIZE) {
-            SDL_RenderDrawLine(renderer, x, 0, x, SCREEN_HEIGHT);
+            canvas.drawLine(x, 0, x, SCREEN_HEIGHT);
         }
         for (int y = 0; y < SCREEN_HEIGHT; y += GRID_SIZE) {
-            SDL_RenderDrawLine(renderer, 0, y, SCREEN_WIDTH, y);
+            canvas.drawLine(0, y, SCREEN_WIDTH, y);
         }
 
         // Translucent overlay for atmosphere
-        SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
-        SDL_SetRenderDrawColor(renderer, 30, 30, 30, 128);
-        SDL_Rect overlayRect = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
-        SDL_RenderFillRect(renderer, &overlayRect);
+        canvas.setBlendMode(SDL_BLENDMODE_BLEND);
+        canvas.setColor(30, 30, 30, 128);
+        canvas.fillRect(SDL_Rect{0, 0, SCREEN_WIDTH, SCREEN_HEIGHT});
 
         // Draw obstacles (blue squares).
-        SDL_SetRenderDrawColor(renderer, 38, 143, 185, 255);
-        for (const auto& obs : obstacles) {
+        canvas.setColor(38, 143, 185, 255);
+        for (const auto& obs : snap.obstacles) {
             SDL_Rect rect = {obs.x, obs.y, GRID_SIZE, GRID_SIZE};
-            SDL_RenderFillRect(renderer, &rect);
+            canvas.fillRect(rect);
         }
 
-        // Draw snake (green squares).
-        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-        for (int i = 0; i < (int)snake.size(); i++) {
-            SDL_Rect rect = {snake[i].x, snake[i].y, GRID_SIZE, GRID_SIZE};
-            SDL_RenderFillRect(renderer, &rect);
+        // Draw snake (green), one rectangle per straight run. Between
+        // ticks the head run stops short of the head by the part of the
+        // cell not yet entered, and the tail trails into the cell it left.
+        canvas.setColor(0, 255, 0, 255);
+        const int entered = (int)(tickProgress(snap) * GRID_SIZE + 0.5f);
+        for (size_t i = 0; i < snap.snakeRects.size(); i++) {
+            SDL_Rect rect = snap.snakeRects[i];
+            if (i == 0 && snap.motion.moving) {
+                rect = trimmed(rect, snap.motion.headDir, GRID_SIZE - entered);
+            }
+            if (rect.w > 0 && rect.h > 0) {
+                canvas.fillRect(rect);
+            }
+        }
+        if (snap.motion.moving && snap.motion.tailMoved && entered < GRID_SIZE) {
+            canvas.fillRect(cellPart(snap.motion.tailFrom, snap.motion.tailDir,
+                                     entered, GRID_SIZE - entered));
         }
 
         // Draw food (red squares).
-        SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-        for (const auto& food : foodItems) {
+        canvas.setColor(255, 0, 0, 255);
+        for (const auto& food : snap.foodItems) {
             SDL_Rect foodRect = {food.x, food.y, GRID_SIZE, GRID_SIZE};
-            SDL_RenderFillRect(renderer, &foodRect);
+            canvas.fillRect(foodRect);
         }
 
-        // If in FLASHLIGHT mode, draw a "fog" except for a radius around head.
-        if (gameMode == GameMode::FLASHLIGHT && !snake.empty()) {
-            renderFlashlight();
-        }
+        renderSparkles(snap);
+    }
 
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-        for (auto &sp : sparkles) {
+    void renderSparkles(const GameSnapshot& snap) {
+        canvas.setColor(255, 255, 255, 255);
+        int sparkles = std::min((int)snap.sparkles.size(), quality.settings().sparkleCap);
+        for (int i = 0; i < sparkles; i++) {
+            const Sparkle& sp = snap.sparkles[i];
             int size = (int)(5 * sp.life);
             SDL_Rect r = {(int)sp.x - size/2, (int)sp.y - size/2, size, size};
-            SDL_RenderFillRect(renderer, &r);
+            canvas.fillRect(r);
         }
     }
 
-    // The "Flashlight" effect: draw a dark overlay over everything except 
-    // around the snake head up to a certain number of blocks.
-    void renderFlashlight() {
-        // We'll determine all the visible cells in a radius around head.
-        Point head = snake.front();
-        int radiusPixels = FLASHLIGHT_RADIUS_BLOCKS * GRID_SIZE;
+    // Grid and overlay over the lit cells only, one run of lit cells in a
+    // row at a time.
+    void renderLitBoard(const std::vector<Uint8>& light) {
+        litRuns.clear();
+        for (int y = 0; y < GRID_ROWS; y++) {
+            const Uint8* row = &light[y * GRID_COLS];
+            int x = 0;
+            while (x < GRID_COLS) {
+                if (row[x] == 0) {
+                    x++;
+                    continue;
+                }
+                int end = x + 1;
+                while (end < GRID_COLS && row[end] != 0) {
+                    end++;
+                }
+                litRuns.push_back(SDL_Rect{x * GRID_SIZE, y * GRID_SIZE,
+                                           (end - x) * GRID_SIZE, GRID_SIZE});
+                x = end;
+            }
+        }
 
-        // Dark overlay
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        // We'll do a simple approach: compute distance from head center 
-        // to each cell center, if it's beyond radius, fill with black.
+        // Each cell's share of the grid: its top and left edges.
+        canvas.setColor(50, 50, 50, 255);
+        for (const SDL_Rect& r : litRuns) {
+            canvas.drawLine(r.x, r.y, r.x + r.w - 1, r.y);
+            for (int x = r.x; x < r.x + r.w; x += GRID_SIZE) {
+                canvas.drawLine(x, r.y, x, r.y + GRID_SIZE - 1);
+            }
+        }
 
-        // Head center position
-        int headCenterX = head.x + GRID_SIZE / 2;
-        int headCenterY = head.y + GRID_SIZE / 2;
-        
-        // Use a smaller grid-based approach to skip overhead
-        for (int y = 0; y < SCREEN_HEIGHT; y += GRID_SIZE) {
-            for (int x = 0; x < SCREEN_WIDTH; x += GRID_SIZE) {
-                // Center of this cell
-                int cx = x + GRID_SIZE / 2;
-                int cy = y + GRID_SIZE / 2;
-
-                // Euclidian distance
-                int dx = cx - headCenterX;
-                int dy = cy - headCenterY;
-                int distSquared = dx*dx + dy*dy;
-
-                // If beyond radius, fill black rectangle
-                if (distSquared > (radiusPixels * radiusPixels)) {
-                    SDL_Rect block = { x, y, GRID_SIZE, GRID_SIZE };
-                    SDL_RenderFillRect(renderer, &block);
+        canvas.setBlendMode(SDL_BLENDMODE_BLEND);
+        canvas.setColor(30, 30, 30, 128);
+        for (const SDL_Rect& r : litRuns) {
+            canvas.fillRect(r);
+        }
+    }
+
+    // Obstacles, snake and food in lit cells, looked up cell by cell in
+    // the occupancy grid rather than by walking every entity. Food is
+    // drawn over snake over obstacles, as in the full view.
+    // The snake's moving ends are drawn part way, as in the full view.
+    void renderLitCells(const GameSnapshot& snap) {
+        const SnakeMotion& m = snap.motion;
+        const int entered = (int)(tickProgress(snap) * GRID_SIZE + 0.5f);
+        const int head = cellIndex(snap.snakeHead);
+        Uint8 drawing = 0;
+        for (int i = 0; i < GRID_COLS * GRID_ROWS; i++) {
+            Uint8 cell = snap.cells[i];
+            if (cell == 0 || snap.light[i] == 0 || (m.moving && i == head)) {
+                continue;
+            }
+            const int x = (i % GRID_COLS) * GRID_SIZE;
+            const int y = (i / GRID_COLS) * GRID_SIZE;
+            Uint8 top = (cell & CELL_FOOD) ? CELL_FOOD
+                      : (cell & CELL_SNAKE) ? CELL_SNAKE
+                      : CELL_OBSTACLE;
+            if (top != drawing) {
+                drawing = top;
+                if (top == CELL_FOOD) {
+                    canvas.setColor(255, 0, 0, 255);
+                } else if (top == CELL_SNAKE) {
+                    canvas.setColor(0, 255, 0, 255);
+                } else {
+                    canvas.setColor(38, 143, 185, 255);
+                }
+            }
+            canvas.fillRect(SDL_Rect{x, y, GRID_SIZE, GRID_SIZE});
+        }
+
+        if (!m.moving) {
+            return;
+        }
+        canvas.setColor(0, 255, 0, 255);
+        if (entered > 0 && snap.light[head] != 0) {
+            canvas.fillRect(cellPart(snap.snakeHead, m.headDir, 0, entered));
+        }
+        if (m.tailMoved && entered < GRID_SIZE && snap.light[cellIndex(m.tailFrom)] != 0) {
+            canvas.fillRect(cellPart(m.tailFrom, m.tailDir, entered, GRID_SIZE - entered));
+        }
+    }
+
+    // How far, from 0 to 1, the game is from the last tick to the next;
+    // 1 (the snapshot as it is) when paused or after anything but a plain
+    // move.
+    float tickProgress(const GameSnapshot& snap) const {
+        const SnakeMotion& m = snap.motion;
+        if (!m.moving || m.interval == 0 || state != GameState::PLAYING) {
+            return 1.0f;
+        }
+        double f = (double)(SDL_GetPerformanceCounter() - m.at) / (double)m.interval;
+        return (float)std::min(1.0, std::max(0.0, f));
+    }
+
+    // The slice of a cell from `from` to `from + length` pixels along dir,
+    // counted from the side dir points away from. A head moving in dir
+    // fills its cell from 0; a tail leaving along dir empties it from 0.
+    static SDL_Rect cellPart(Point cell, Point dir, int from, int length) {
+        SDL_Rect r = {cell.x, cell.y, GRID_SIZE, GRID_SIZE};
+        if (dir.x != 0) {
+            r.x = (dir.x > 0) ? cell.x + from : cell.x + GRID_SIZE - from - length;
+            r.w = length;
+        } else if (dir.y != 0) {
+            r.y = (dir.y > 0) ? cell.y + from : cell.y + GRID_SIZE - from - length;
+            r.h = length;
+        }
+        return r;
+    }
+
+    // rect with cut pixels taken off its dir side.
+    static SDL_Rect trimmed(SDL_Rect rect, Point dir, int cut) {
+        if (dir.x > 0) {
+            rect.w -= cut;
+        } else if (dir.x < 0) {
+            rect.x += cut;
+            rect.w -= cut;
+        } else if (dir.y > 0) {
+            rect.h -= cut;
+        } else if (dir.y < 0) {
+            rect.y += cut;
+            rect.h -= cut;
+        }
+        return rect;
+    }
+
+    // Darkness from the light map, as blended black rectangles, one per
+    // run of equally dark lit cells in a row; unlit cells were never drawn
+    // and are still black. They are shapes like the rest of the board, so
+    // whatever is drawn after them (sparkles, the pause menu) stays on
+    // top. Each cell's darkness is worked out again only when a new
+    // snapshot (a tick) or quality level arrives.
+    void renderFog(const GameSnapshot& snap) {
+        const int softness = quality.settings().flashlightSoftness;
+        if (snap.sequence != fogSequence || softness != fogSoftness) {
+            fogSequence = snap.sequence;
+            fogSoftness = softness;
+            for (size_t i = 0; i < fogAlphas.size() && i < snap.light.size(); i++) {
+                fogAlphas[i] = fogAlpha(snap.light[i], softness);
+            }
+        }
+        canvas.setBlendMode(SDL_BLENDMODE_BLEND);
+        for (int y = 0; y < GRID_ROWS; y++) {
+            const Uint8* row = &fogAlphas[y * GRID_COLS];
+            int x = 0;
+            while (x < GRID_COLS) {
+                int end = x + 1;
+                while (end < GRID_COLS && row[end] == row[x]) {
+                    end++;
                 }
+                if (row[x] > 0 && row[x] < 255) {
+                    canvas.setColor(0, 0, 0, row[x]);
+                    canvas.fillRect(SDL_Rect{x * GRID_SIZE, y * GRID_SIZE,
+                                             (end - x) * GRID_SIZE, GRID_SIZE});
+                }
+                x = end;
             }
         }
     }
 
+    // Light levels are shown in softness + 1 steps, so at the lowest
+    // quality the light has a hard edge. Only a level of 0 is fully dark.
+    static Uint8 fogAlpha(Uint8 level, int softness) {
+        int steps = softness + 1;
+        int lit = (level * steps + 254) / 255;
+        return (Uint8)(255 - 255 * lit / steps);
+    }
+
     //---------------------------------------------------
     //    PROCEDURAL GRASS: GENERATE & RENDER
     //---------------------------------------------------
-    void generateGrass() {
-        grassBlades.clear();
-        int totalBlades = 3000;
-        grassBlades.reserve(totalBlades);
+    // Take over whatever the loader produced.
+    void adoptAssets(LoadedAssets& a) {
+        font           = a.font;
+        scoreFont      = a.scoreFont;
+        grassBlades.swap(a.grass);
+        assetsReady    = true;
+        sceneDirty     = true;
+        updateGrassTips();
+        if (a.audioOpen) {
+            sim.enableSound();
+        }
+    }
 
-        for (int i = 0; i < totalBlades; ++i) {
-            GrassBlade blade;
-            blade.x              = static_cast<float>(std::rand() % SCREEN_WIDTH);
-            // random bottom half
-            blade.y              = SCREEN_HEIGHT - (std::rand() % (SCREEN_HEIGHT / 2));
-            blade.height         = 10.0f + static_cast<float>(std::rand() % 40);
-            blade.waveOffset     = static_cast<float>(std::rand() % 100) * 0.1f;
-            blade.randomAmplitude= 0.5f + static_cast<float>(std::rand() % 10);
-            grassBlades.push_back(blade);
+    void pollAssets() {
+        LoadedAssets a;
+        if (!assetLoader.poll(a)) {
+            return;
+        }
+        adoptAssets(a);
+        startup.assetsMs = millisSince(PROCESS_START);
+        if (reportStartup) {
+            std::cout << "startup: init=" << startup.initMs << "ms"
+                      << " window=" << startup.windowMs << "ms"
+                      << " first frame=" << startup.firstFrameMs << "ms"
+                      << " assets ready=" << startup.assetsMs << "ms"
+                      << " (audio " << a.audioMs << "ms, fonts " << a.fontMs
+                      << "ms, sounds " << a.soundMs << "ms, grass " << a.grassMs << "ms)" << std::endl;
         }
     }
 
-    void renderGrass() {
-        // Grass color
-        SDL_SetRenderDrawColor(renderer, 34, 139, 34, 255);
-        for (auto& blade : grassBlades) {
+    // Until the assets arrive: a sweeping bar along the bottom edge.
+    void renderLoadingBar() {
+        const int width = SCREEN_WIDTH / 4;
+        int x = (int)(SDL_GetTicks() / 2 % (SCREEN_WIDTH + width)) - width;
+        SDL_Rect bar = {x, SCREEN_HEIGHT - 6, width, 4};
+        canvas.setColor(255, 255, 0, 255);
+        canvas.fillRect(bar);
+    }
+
+    // Move the blade tips to animationTime. The scene only changes if a
+    // tip lands on a different pixel. Only as many blades as the quality
+    // level allows are animated and drawn.
+    void updateGrassTips() {
+        size_t count = std::min(grassBlades.size(), (size_t)quality.settings().grassBlades);
+        grassTips.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const GrassBlade& blade = grassBlades[i];
             float wave = std::sin(animationTime * grassWaveSpeed + blade.waveOffset) 
                          * grassWaveAmplitude 
                          * blade.randomAmplitude 
                          * 0.1f;
-            float tipX = blade.x + wave;
-            float tipY = blade.y - blade.height;
+            SDL_Point tip = {
+                static_cast<int>(blade.x + wave),
+                static_cast<int>(blade.y - blade.height)
+            };
+            if (tip.x != grassTips[i].x || tip.y != grassTips[i].y) {
+                grassTips[i] = tip;
+                sceneDirty   = true;
+            }
+        }
+    }
 
-            SDL_RenderDrawLine(
-                renderer,
-                static_cast<int>(blade.x),
-                static_cast<int>(blade.y),
-                static_cast<int>(tipX),
-                static_cast<int>(tipY)
-            );
+    // With a light map, only blades whose bounds lie wholly on lit cells
+    // are drawn, so none pokes into the dark.
+    void renderGrass(const std::vector<Uint8>* lit) {
+        // Grass color
+        canvas.setColor(34, 139, 34, 255);
+        for (size_t i = 0; i < grassTips.size(); i++) {
+            int baseX = static_cast<int>(grassBlades[i].x);
+            int baseY = static_cast<int>(grassBlades[i].y);
+            if (lit && !allLit(*lit, std::min(baseX, grassTips[i].x),
+                               std::min(baseY, grassTips[i].y),
+                               std::max(baseX, grassTips[i].x),
+                               std::max(baseY, grassTips[i].y))) {
+                continue;
+            }
+            canvas.drawLine(baseX, baseY, grassTips[i].x, grassTips[i].y);
         }
     }
 
+    // Whether every cell under the pixels left..right, top..bottom
+    // (inclusive, clipped to the board) has some light.
+    static bool allLit(const std::vector<Uint8>& light, int left, int top, int right, int bottom) {
+        int x0 = std::max(0, left / GRID_SIZE);
+        int y0 = std::max(0, top / GRID_SIZE);
+        int x1 = std::min(GRID_COLS - 1, right / GRID_SIZE);
+        int y1 = std::min(GRID_ROWS - 1, bottom / GRID_SIZE);
+        for (int y = y0; y <= y1; y++) {
+            for (int x = x0; x <= x1; x++) {
+                if (light[y * GRID_COLS + x] == 0) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
     //---------------------------------------------------
     //                   MENUS
     //---------------------------------------------------
@@ -727,8 +1165,23 @@ private:
         );
 
         renderConfigLine(
-            "Back to Main Menu",
+            "Rewind history (ticks): " + std::to_string(rewindTicks),
             400,
+            (configOption == (int)ConfigOption::REWIND) ? highlight : normal
+        );
+
+        std::string qualityName = quality.automatic()
+            ? std::string("AUTO (") + quality.settings().name + ")"
+            : std::string(quality.settings().name);
+        renderConfigLine(
+            "Quality: " + qualityName,
+            450,
+            (configOption == (int)ConfigOption::QUALITY) ? highlight : normal
+        );
+
+        renderConfigLine(
+            "Back to Main Menu",
+            500,
             (configOption == (int)ConfigOption::EXIT) ? highlight : normal
         );
 
@@ -741,43 +1194,56 @@ private:
         );
     }
 
-    // Mode menu to select NORMAL or FLASHLIGHT.
+    // Mode menu to select NORMAL, FLASHLIGHT or SHADOWS.
     void renderModeMenu() {
         renderText("CHOOSE GAME MODE", SCREEN_WIDTH / 2, 60, 28, SDL_Color{255, 255, 0, 255});
 
-        // We'll define 0->Normal, 1->Flashlight in modeMenuOption.
+        // We'll define 0->Normal, 1->Flashlight, 2->Shadows in modeMenuOption.
         SDL_Color selColor   = {255, 255, 0, 255};
         SDL_Color otherColor = {255, 255, 255, 255};
 
+        if (!font) {
+            return;
+        }
+
         // For index=0 => Normal
         SDL_Color colorNormal = (modeMenuOption == 0) ? selColor : otherColor;
-        SDL_Surface* surfaceNormal = TTF_RenderText_Solid(font, "NORMAL MODE", colorNormal);
-        SDL_Texture* textureNormal = SDL_CreateTextureFromSurface(renderer, surfaceNormal);
-
-        SDL_Rect normalRect {
-            (SCREEN_WIDTH - surfaceNormal->w) / 2,
-            200,
-            surfaceNormal->w,
-            surfaceNormal->h
-        };
-        SDL_RenderCopy(renderer, textureNormal, nullptr, &normalRect);
-        SDL_FreeSurface(surfaceNormal);
-        SDL_DestroyTexture(textureNormal);
+        const CachedText* normal = texts.get(font, "NORMAL MODE", colorNormal);
+        if (normal) {
+            SDL_Rect normalRect {
+                (SCREEN_WIDTH - normal->w) / 2,
+                200,
+                normal->w,
+                normal->h
+            };
+            canvas.drawTexture(normal->texture, normalRect);
+        }
 
         // For index=1 => Flashlight
         SDL_Color colorFlash = (modeMenuOption == 1) ? selColor : otherColor;
-        SDL_Surface* surfaceFlash = TTF_RenderText_Solid(font, "FLASHLIGHT MODE", colorFlash);
-        SDL_Texture* textureFlash = SDL_CreateTextureFromSurface(renderer, surfaceFlash);
-
-        SDL_Rect flashRect {
-            (SCREEN_WIDTH - surfaceFlash->w) / 2,
-            260,
-            surfaceFlash->w,
-            surfaceFlash->h
-        };
-        SDL_RenderCopy(renderer, textureFlash, nullptr, &flashRect);
-        SDL_FreeSurface(surfaceFlash);
-        SDL_DestroyTexture(textureFlash);
+        const CachedText* flash = texts.get(font, "FLASHLIGHT MODE", colorFlash);
+        if (flash) {
+            SDL_Rect flashRect {
+                (SCREEN_WIDTH - flash->w) / 2,
+                260,
+                flash->w,
+                flash->h
+            };
+            canvas.drawTexture(flash->texture, flashRect);
+        }
+
+        // For index=2 => Shadows
+        SDL_Color colorShadows = (modeMenuOption == 2) ? selColor : otherColor;
+        const CachedText* shadows = texts.get(font, "SHADOW MODE", colorShadows);
+        if (shadows) {
+            SDL_Rect shadowsRect {
+                (SCREEN_WIDTH - shadows->w) / 2,
+                320,
+                shadows->w,
+                shadows->h
+            };
+            canvas.drawTexture(shadows->texture, shadowsRect);
+        }
 
         renderText(
             "Use UP/DOWN to highlight, ENTER to confirm. ESC to return",
@@ -792,11 +1258,52 @@ private:
     //             SCORE & TEXT RENDERING
     //---------------------------------------------------
     void renderScore() {
-        std::string scoreMsg = "Score: " + std::to_string(score);
+        const GameSnapshot& snap = sim.snapshot();
+        std::string scoreMsg = "Score: " + std::to_string(snap.score);
         renderDynamicText(scoreMsg.c_str(), 10, 10, 255, 255, 255);
 
-        std::string highScoreMsg = "High: " + std::to_string(highScore);
+        std::string highScoreMsg = "High: " + std::to_string(snap.highScore);
         renderDynamicText(highScoreMsg.c_str(), 10, 40, 255, 255, 0);
+
+        if (replaying) {
+            std::string replayMsg = "REPLAY x" + std::to_string(snap.playbackSpeed) +
+                                    "  TICK " + std::to_string(snap.replayPosition);
+            renderDynamicText(replayMsg.c_str(), 10, 70, 0, 200, 255);
+        } else if (pilotMode == PilotMode::SEARCH) {
+            renderDynamicText("AUTOPILOT: BFS", 10, 70, 0, 200, 255);
+        } else if (pilotMode == PilotMode::CYCLE) {
+            renderDynamicText("AUTOPILOT: CYCLE", 10, 70, 0, 200, 255);
+        } else if (pilotMode == PilotMode::LOOKAHEAD) {
+            renderDynamicText("AUTOPILOT: LOOKAHEAD", 10, 70, 0, 200, 255);
+        }
+        if (snap.rewinding) {
+            std::string rewindMsg = "<< REWIND (" +
+                std::to_string(snap.rewindAvailable) + " ticks left)";
+            renderDynamicText(rewindMsg.c_str(), 10, 100, 255, 120, 120);
+        }
+    }
+
+    // F3: frame rate, frame time against the budget, and quality level.
+    void renderOverlay() {
+        Uint32 now = SDL_GetTicks();
+        Uint32 elapsed = now - overlayUpdated;
+        if (overlayText.empty() || elapsed >= OVERLAY_REFRESH_MS) {
+            char line[128];
+            std::snprintf(line, sizeof(line), "FPS %.0f  FRAME %.1fms / %.1fms  QUALITY %s%s  RENDER %s x%u%s",
+                          elapsed > 0 ? 1000.0 * overlayFrames / elapsed : 0.0,
+                          overlayFrames > 0 ? overlayWorkMs / overlayFrames : 0.0,
+                          quality.budgetMs(),
+                          quality.settings().name,
+                          quality.automatic() ? " (AUTO)" : "",
+                          backendName(canvas.backend()),
+                          canvas.rasterThreads(),
+                          vsynced ? " VSYNC" : "");
+            overlayText    = line;
+            overlayUpdated = now;
+            overlayFrames  = 0;
+            overlayWorkMs  = 0.0;
+        }
+        renderDynamicText(overlayText.c_str(), 10, SCREEN_HEIGHT - 30, 0, 255, 128);
     }
 
     void renderButton(const char* text, int index, int selectedIndex) {
@@ -810,22 +1317,22 @@ private:
         rect.x = SCREEN_WIDTH / 2 - rect.w / 2;
         rect.y = 200 + index * 60;
 
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-        SDL_RenderFillRect(renderer, &rect);
+        canvas.setColor(color.r, color.g, color.b, color.a);
+        canvas.fillRect(rect);
 
-        SDL_Surface* surface = TTF_RenderText_Solid(font, text, SDL_Color{0, 0, 0, 255});
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        const CachedText* t = texts.get(font, text, SDL_Color{0, 0, 0, 255});
+        if (!t) {
+            return;
+        }
 
         SDL_Rect textRect {
-            rect.x + (rect.w - surface->w) / 2,
-            rect.y + (rect.h - surface->h) / 2,
-            surface->w,
-            surface->h
+            rect.x + (rect.w - t->w) / 2,
+            rect.y + (rect.h - t->h) / 2,
+            t->w,
+            t->h
         };
 
-        SDL_RenderCopy(renderer, texture, nullptr, &textRect);
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        canvas.drawTexture(t->texture, textRect);
     }
 
     void renderPauseButton(const char* text, int index) {
@@ -839,155 +1346,154 @@ private:
         rect.x = SCREEN_WIDTH / 2 - rect.w / 2;
         rect.y = SCREEN_HEIGHT / 2 - 20 + (index * 60);
 
-        SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
-        SDL_RenderFillRect(renderer, &rect);
+        canvas.setColor(color.r, color.g, color.b, color.a);
+        canvas.fillRect(rect);
 
-        SDL_Surface* surface = TTF_RenderText_Solid(font, text, SDL_Color{0, 0, 0, 255});
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        const CachedText* t = texts.get(font, text, SDL_Color{0, 0, 0, 255});
+        if (!t) {
+            return;
+        }
 
         SDL_Rect textRect {
-            rect.x + (rect.w - surface->w) / 2,
-            rect.y + (rect.h - surface->h) / 2,
-            surface->w,
-            surface->h
+            rect.x + (rect.w - t->w) / 2,
+            rect.y + (rect.h - t->h) / 2,
+            t->w,
+            t->h
         };
 
-        SDL_RenderCopy(renderer, texture, nullptr, &textRect);
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        canvas.drawTexture(t->texture, textRect);
     }
 
     void renderConfigLine(const std::string& txt, int y, SDL_Color color) {
-        SDL_Surface* surface = TTF_RenderText_Solid(font, txt.c_str(), color);
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+        const CachedText* t = texts.get(font, txt.c_str(), color);
+        if (!t) {
+            return;
+        }
 
         SDL_Rect textRect;
-        textRect.w = surface->w;
-        textRect.h = surface->h;
-        textRect.x = (SCREEN_WIDTH - surface->w) / 2;
+        textRect.w = t->w;
+        textRect.h = t->h;
+        textRect.x = (SCREEN_WIDTH - t->w) / 2;
         textRect.y = y;
 
-        SDL_RenderCopy(renderer, texture, nullptr, &textRect);
-
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        canvas.drawTexture(t->texture, textRect);
     }
 
     void renderText(const char* text, int centerX, int centerY, int fontSize, SDL_Color color) {
-        TTF_Font* tempFont = TTF_OpenFont("COMIC.TTF", fontSize);
-        if (!tempFont) {
+        // The loader may still be inside SDL_ttf on its own thread.
+        if (!assetsReady) {
+            return;
+        }
+        const CachedText* t = texts.get(texts.font(fontSize), text, color);
+        if (!t) {
             return;
         }
 
-        SDL_Surface* surface = TTF_RenderText_Solid(tempFont, text, color);
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-
-        SDL_Rect textRect{0, 0, surface->w, surface->h};
-        textRect.x = centerX - (surface->w / 2);
-        textRect.y = centerY - (surface->h / 2);
-
-        SDL_RenderCopy(renderer, texture, nullptr, &textRect);
+        SDL_Rect textRect{0, 0, t->w, t->h};
+        textRect.x = centerX - (t->w / 2);
+        textRect.y = centerY - (t->h / 2);
 
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
-        TTF_CloseFont(tempFont);
+        canvas.drawTexture(t->texture, textRect);
     }
 
     void renderDynamicText(const char* text, int x, int y, Uint8 r, Uint8 g, Uint8 b) {
-        SDL_Color color { r, g, b, 255 };
-        SDL_Surface* surface = TTF_RenderText_Solid(scoreFont, text, color);
-        SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
-
-        SDL_Rect textRect = { x, y, surface->w, surface->h };
-        SDL_RenderCopy(renderer, texture, nullptr, &textRect);
+        const CachedText* t = texts.get(scoreFont, text, SDL_Color{ r, g, b, 255 });
+        if (!t) {
+            return;
+        }
 
-        SDL_FreeSurface(surface);
-        SDL_DestroyTexture(texture);
+        SDL_Rect textRect = { x, y, t->w, t->h };
+        canvas.drawTexture(t->texture, textRect);
     }
 
     //---------------------------------------------------
-    //             START & RESET GAME
+    //             START & LEAVE GAME
     //---------------------------------------------------
     void startGame() {
         state = GameState::PLAYING;
-        resetGame();
+        sim.send(SimCommand{SimCommandType::START_GAME, 0, {0, 0}, sessionConfig(), 0});
     }
 
-    void resetGame() {
-        snake.clear();
-        snake.push_back({SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2});
-        direction = {1, 0};
-        score     = 0;
-
-        foodItems.clear();
-        obstacles.clear();
-        spawnFood();
-        spawnObstacles(numObstacles);
+    SessionConfig sessionConfig() const {
+        return SessionConfig{snakeSpeed, numFoodItems, numObstacles, rewindTicks,
+                             gameMode, pilotMode};
     }
 
-    //---------------------------------------------------
-    //       SPAWNING FOOD & OBSTACLES
-    //---------------------------------------------------
-    void spawnFood() {
-        for (int i = 0; i < numFoodItems; i++) {
-            Point food;
-            bool validPos = false;
-            while (!validPos) {
-                food.x = (std::rand() % (SCREEN_WIDTH / GRID_SIZE)) * GRID_SIZE;
-                food.y = (std::rand() % (SCREEN_HEIGHT / GRID_SIZE)) * GRID_SIZE;
-                validPos = true;
-                // check snake
-                for (auto& seg : snake) {
-                    if (food == seg) {
-                        validPos = false;
-                        break;
-                    }
-                }
-                // check obstacles
-                for (auto& obs : obstacles) {
-                    if (food == obs) {
-                        validPos = false;
-                        break;
-                    }
-                }
-            }
-            foodItems.push_back(food);
-        }
-    }
-
-    void spawnObstacles(int count) {
-        for (int i = 0; i < count; i++) {
-            Point obs;
-            bool validPos = false;
-            while (!validPos) {
-                obs.x = (std::rand() % (SCREEN_WIDTH / GRID_SIZE)) * GRID_SIZE;
-                obs.y = (std::rand() % (SCREEN_HEIGHT / GRID_SIZE)) * GRID_SIZE;
-                validPos = true;
-                // check snake
-                for (auto& seg : snake) {
-                    if (obs == seg) {
-                        validPos = false;
-                        break;
-                    }
-                }
-                // check food
-                for (auto& f : foodItems) {
-                    if (obs == f) {
-                        validPos = false;
-                        break;
-                    }
-                }
-            }
-            obstacles.push_back(obs);
-        }
+    // Back to the main menu from a game or a playback.
+    void leaveGame() {
+        sim.send(SimCommandType::LEAVE_GAME);
+        rewinding = false;
+        replaying = false;
+        state     = GameState::MAIN_MENU;
     }
 };
 
 //-------------------------------------------------------
 //                        MAIN
 //-------------------------------------------------------
-int main() {
-    Application app;
+int main(int argc, char* argv[]) {
+    PilotMode pilot = PilotMode::OFF;
+    std::string playPath;
+    bool startupProfile = false;
+    AudioConfig audioConfig;
+    int menuFps = -1;  // -1: the backend's own rate
+    double frameBudget = DEFAULT_FRAME_BUDGET_MS;
+    RenderBackend backend = RenderBackend::AUTO;
+    int rasterThreads = 0;
+    bool vsync = true;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--bench") {
+            return runBenchmarks();
+        } else if (arg == "--autopilot") {
+            pilot = PilotMode::SEARCH;
+        } else if (arg == "--autopilot=cycle") {
+            pilot = PilotMode::CYCLE;
+        } else if (arg == "--autopilot=lookahead") {
+            pilot = PilotMode::LOOKAHEAD;
+        } else if (arg == "--replay" && i + 1 < argc) {
+            return runReplay(argv[i + 1]);
+        } else if (arg == "--analyze") {
+            return runAnalyze(std::vector<std::string>(argv + i + 1, argv + argc));
+        } else if (arg == "--play" && i + 1 < argc) {
+            playPath = argv[++i];
+        } else if (arg == "--startup-profile") {
+            startupProfile = true;
+        } else if (arg == "--assets" && i + 1 < argc) {
+            resources().setOverrideDir(argv[++i]);
+        } else if (arg == "--audio-buffer" && i + 1 < argc) {
+            audioConfig.bufferSamples = std::atoi(argv[++i]);
+        } else if (arg == "--menu-fps" && i + 1 < argc) {
+            menuFps = std::atoi(argv[++i]);
+        } else if (arg == "--frame-budget" && i + 1 < argc) {
+            frameBudget = std::atof(argv[++i]);
+        } else if (arg == "--renderer" && i + 1 < argc) {
+            std::string name = argv[++i];
+            backend = (name == "sdl")      ? RenderBackend::SDL
+                    : (name == "software") ? RenderBackend::SOFTWARE
+                    : RenderBackend::AUTO;
+        } else if (arg == "--raster-threads" && i + 1 < argc) {
+            rasterThreads = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--no-vsync") {
+            vsync = false;
+        }
+    }
+
+    Application app(audioConfig, backend, vsync);
+    app.setStartupReport(startupProfile);
+    if (menuFps >= 0) {
+        app.setMenuFrameRate(menuFps);
+    }
+    app.setFrameBudget(frameBudget);
+    app.setRasterThreads((unsigned)rasterThreads);
+    if (!playPath.empty()) {
+        if (!app.startReplay(playPath)) {
+            std::cerr << "Cannot play replay " << playPath << "\n";
+            return 1;
+        }
+    } else if (pilot != PilotMode::OFF) {
+        app.startAutopilot(pilot);
+    }
     app.run();
     return 0;
 }
\ No newline at end of file
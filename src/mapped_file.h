@@ -0,0 +1,134 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//-------------------------------------------------------
+//                  MEMORY-MAPPED FILE
+//-------------------------------------------------------
+// Read-only view of a whole file. The OS pages it in on demand, so readers
+// decode straight from the page cache without copying into a buffer.
+class MappedFile {
+public:
+    MappedFile()
+        : bytes(nullptr),
+          length(0)
+#ifdef _WIN32
+        , fileHandle(INVALID_HANDLE_VALUE),
+          mappingHandle(nullptr)
+#endif
+    {
+    }
+
+    ~MappedFile() {
+        close();
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const Uint8* data() const { return bytes; }
+    size_t       size() const { return length; }
+
+    // Map the file at path, replacing any previous mapping. An empty file
+    // maps successfully to a null view of size 0.
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (fileHandle == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(fileHandle, &fileSize)) {
+            close();
+            return false;
+        }
+        length = (size_t)fileSize.QuadPart;
+        if (length == 0) {
+            return true;
+        }
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mappingHandle) {
+            close();
+            return false;
+        }
+        bytes = (const Uint8*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = (size_t)st.st_size;
+        if (length == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        // The mapping keeps its own reference to the file.
+        ::close(fd);
+        if (view == MAP_FAILED) {
+            length = 0;
+            return false;
+        }
+        madvise(view, length, MADV_SEQUENTIAL);
+        bytes = (const Uint8*)view;
+#endif
+        if (!bytes) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (bytes) {
+            UnmapViewOfFile(bytes);
+        }
+        if (mappingHandle) {
+            CloseHandle(mappingHandle);
+            mappingHandle = nullptr;
+        }
+        if (fileHandle != INVALID_HANDLE_VALUE) {
+            CloseHandle(fileHandle);
+            fileHandle = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (bytes) {
+            munmap((void*)bytes, length);
+        }
+#endif
+        bytes  = nullptr;
+        length = 0;
+    }
+
+private:
+    const Uint8* bytes;
+    size_t       length;
+#ifdef _WIN32
+    HANDLE       fileHandle;
+    HANDLE       mappingHandle;
+#endif
+};
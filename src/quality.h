@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+
+#include "assets.h"
+
+//-------------------------------------------------------
+//                    QUALITY LEVELS
+//-------------------------------------------------------
+// What each level draws. Blades are a random scatter, so drawing the
+// first N of them thins the field evenly.
+struct QualityLevel {
+    const char* name;
+    int grassBlades;
+    int flashlightSoftness;    // light steps shown above dark, less one
+    int sparkleCap;            // most sparkles drawn at once
+};
+
+const QualityLevel QUALITY_LEVELS[] = {
+    {"LOW",    GRASS_BLADE_COUNT / 4, 0, 8},
+    {"MEDIUM", GRASS_BLADE_COUNT / 2, 1, 20},
+    {"HIGH",   GRASS_BLADE_COUNT,     2, 64},
+};
+const int QUALITY_LEVEL_COUNT = (int)(sizeof(QUALITY_LEVELS) / sizeof(QUALITY_LEVELS[0]));
+
+// Frame time the governor aims for: one frame at 60Hz.
+const double DEFAULT_FRAME_BUDGET_MS = 16.6;
+
+// Drop a level once the average over QUALITY_DROP_FRAMES frames is over
+// budget by this ratio; raise one once QUALITY_RAISE_FRAMES average under
+// this share of it. Raising takes longer and needs real headroom, so a
+// frame time near the budget does not flip back and forth.
+const double QUALITY_DROP_RATIO  = 1.10;
+const double QUALITY_RAISE_RATIO = 0.60;
+const int    QUALITY_DROP_FRAMES  = 30;
+const int    QUALITY_RAISE_FRAMES = 180;
+
+// The config menu cycles through automatic and the fixed levels.
+const int QUALITY_AUTO = -1;
+
+//-------------------------------------------------------
+//                   QUALITY GOVERNOR
+//-------------------------------------------------------
+// Picks the quality level from measured frame times to hold a budget.
+// Feed it the time spent on each drawn frame (not time spent sleeping);
+// with a fixed level set it only keeps the statistics.
+class QualityGovernor {
+public:
+    QualityGovernor()
+        : budget(DEFAULT_FRAME_BUDGET_MS),
+          fixed(QUALITY_AUTO),
+          current(QUALITY_LEVEL_COUNT - 1),
+          overSum(0.0),
+          overFrames(0),
+          underSum(0.0),
+          underFrames(0),
+          lastAverage(0.0),
+          changes(0)
+    {
+    }
+
+    void setBudgetMs(double ms) {
+        budget = std::max(1.0, ms);
+    }
+
+    // QUALITY_AUTO, or a level to hold regardless of frame time.
+    void setMode(int mode) {
+        fixed = (mode < 0) ? QUALITY_AUTO : std::min(mode, QUALITY_LEVEL_COUNT - 1);
+        if (fixed != QUALITY_AUTO) {
+            current = fixed;
+        }
+        resetWindows();
+    }
+
+    void frame(double ms) {
+        overSum += ms;
+        underSum += ms;
+        overFrames++;
+        underFrames++;
+        if (overFrames == QUALITY_DROP_FRAMES) {
+            lastAverage = overSum / overFrames;
+            if (fixed == QUALITY_AUTO && current > 0 && lastAverage > budget * QUALITY_DROP_RATIO) {
+                change(current - 1);
+                return;
+            }
+            overSum = 0.0;
+            overFrames = 0;
+        }
+        if (underFrames == QUALITY_RAISE_FRAMES) {
+            double average = underSum / underFrames;
+            if (fixed == QUALITY_AUTO && current < QUALITY_LEVEL_COUNT - 1 &&
+                average < budget * QUALITY_RAISE_RATIO) {
+                change(current + 1);
+                return;
+            }
+            underSum = 0.0;
+            underFrames = 0;
+        }
+    }
+
+    const QualityLevel& settings() const { return QUALITY_LEVELS[current]; }
+    int    level() const      { return current; }
+    int    mode() const       { return fixed; }
+    bool   automatic() const  { return fixed == QUALITY_AUTO; }
+    double budgetMs() const   { return budget; }
+    double averageMs() const  { return lastAverage; }    // over the last drop window
+    int    levelChanges() const { return changes; }
+
+private:
+    double budget;
+    int    fixed;
+    int    current;
+    double overSum;
+    int    overFrames;
+    double underSum;
+    int    underFrames;
+    double lastAverage;
+    int    changes;
+
+    void change(int level) {
+        current = level;
+        changes++;
+        resetWindows();
+    }
+
+    // A new level starts with fresh measurements.
+    void resetWindows() {
+        overSum = 0.0;
+        overFrames = 0;
+        underSum = 0.0;
+        underFrames = 0;
+    }
+};
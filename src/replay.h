@@ -0,0 +1,732 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "byte_io.h"
+#include "game_world.h"
+#include "mapped_file.h"
+
+//-------------------------------------------------------
+//                    REPLAY FORMAT
+//-------------------------------------------------------
+// A replay is the seed and config a session started with, followed by one
+// direction per tick. Since GameWorld is deterministic, that is enough to
+// rebuild every frame, including the restarts after each collision.
+//
+// Layout (all integers little-endian):
+//   0  "CSNR"
+//   4  u16 version
+//   6  u16 header size (offset of the move stream)
+//   8  u64 seed
+//  16  u16 grid cols, u16 grid rows
+//  20  u16 food count, u16 obstacle count
+//  24  u8  game mode, u8 reserved, i16 snake speed (ms per tick)
+//  28  u32 keyframe interval in ticks (0 = none; version 1: reserved)
+//  32  move stream
+//
+// Moves are coded 0..3 in DIRECTIONS order. The stream is a sequence of
+// packets:
+//   0ddnnnnn            run of n+1 moves in direction dd (1..32)
+//   10nnnnnn + bytes    n+1 literal moves (1..64), 2 bits each, LSB first
+//   11000000 + u32 n    keyframe: n bytes of full world state (see below)
+//   11111111            end of stream
+// A stream cut short by a crash simply ends at the last whole packet.
+//
+// Keyframe payload: u64 tick, u64 rng state, i32 score, u8 direction,
+// u8 reserved, u16 snake / food / obstacle counts, then every point as a
+// u16 cell index. It is the state after `tick` moves, collisions already
+// handled, so playback can resume from it as if it had played up to there.
+//
+// After the end marker, version 2 files carry an index of the keyframes:
+//   per keyframe   u64 tick, u64 file offset of its packet
+//   trailer        u64 offset of the index, u32 count, "CSNI"
+// Files without a trailer (version 1, or a crash before close) are indexed
+// by scanning the stream on load. A file whose trailer points anywhere but
+// at whole keyframes is refused.
+
+const Uint16 REPLAY_VERSION     = 2;
+const Uint16 REPLAY_HEADER_SIZE = 32;
+
+const Uint8 REPLAY_LITERAL      = 0x80;
+const Uint8 REPLAY_MARKER       = 0xC0;
+const Uint8 REPLAY_KEYFRAME     = 0xC0;
+const Uint8 REPLAY_END          = 0xFF;
+
+const int REPLAY_TRAILER_SIZE   = 16;
+
+// Default ticks between keyframes. Seeking fast-forwards at most this far,
+// and each keyframe costs a few hundred bytes.
+const Uint32 REPLAY_KEYFRAME_INTERVAL = 16384;
+
+// Runs shorter than this are cheaper as literals.
+const int REPLAY_MIN_RUN        = 4;
+const int REPLAY_MAX_RUN        = 32;
+const int REPLAY_MAX_LITERAL    = 64;
+
+struct ReplayHeader {
+    Uint64 seed;
+    Uint16 cols;
+    Uint16 rows;
+    Uint16 numFoodItems;
+    Uint16 numObstacles;
+    Uint8  gameMode;
+    Sint16 snakeSpeed;
+    Uint32 keyframeInterval;
+};
+
+struct ReplayKeyframe {
+    Uint64 tick;
+    size_t offset;     // file offset of the keyframe packet
+};
+
+// 2-bit code of a direction, matching DIRECTIONS.
+inline int directionCode(Point dir) {
+    // Without branches: the recorder runs this every tick, and the way
+    // the snake turns is hard to predict.
+    return (dir.x == 0) * 2 + (dir.x < 0) + (dir.y < 0);
+}
+
+// Append a keyframe payload for the world as it stands after `tick` moves.
+inline void encodeKeyframe(std::vector<Uint8>& out, const GameWorld& world, Uint64 tick) {
+    putLE(out, tick, 8);
+    putLE(out, world.rng.state, 8);
+    putLE(out, (Uint32)world.score, 4);
+    putLE(out, (Uint64)directionCode(world.direction), 1);
+    putLE(out, 0, 1);
+    putLE(out, world.snake.size(), 2);
+    putLE(out, world.foodItems.size(), 2);
+    putLE(out, world.obstacles.size(), 2);
+    for (const auto* list : {&world.snake, &world.foodItems, &world.obstacles}) {
+        for (const Point& p : *list) {
+            putLE(out, (Uint64)cellIndex(p), 2);
+        }
+    }
+}
+
+// Load a keyframe payload into the world. Spawn counts and the seed must
+// already be set; the occupancy grid is rebuilt from the lists. A payload
+// with no snake, or with a list longer than the board has cells, is
+// rejected before the world is touched.
+inline bool decodeKeyframe(const Uint8* in, size_t size, GameWorld& world) {
+    const size_t fixed = 28;
+    if (size < fixed) {
+        return false;
+    }
+    size_t counts[3] = {
+        (size_t)getLE(in + 22, 2), (size_t)getLE(in + 24, 2), (size_t)getLE(in + 26, 2)
+    };
+    const size_t cellsTotal = GRID_COLS * GRID_ROWS;
+    if (counts[0] == 0 || counts[0] > cellsTotal || counts[1] > cellsTotal ||
+        counts[2] > cellsTotal) {
+        return false;
+    }
+    if (size < fixed + 2 * (counts[0] + counts[1] + counts[2])) {
+        return false;
+    }
+    world.ticks     = getLE(in, 8);
+    world.rng.state = getLE(in + 8, 8);
+    world.score     = (int)(Sint32)getLE(in + 16, 4);
+    world.direction = DIRECTIONS[in[20] & 3];
+
+    const Uint8 flags[3] = {CELL_SNAKE, CELL_FOOD, CELL_OBSTACLE};
+    std::vector<Point>* lists[3] = {&world.snake, &world.foodItems, &world.obstacles};
+    std::fill(world.cells.begin(), world.cells.end(), 0);
+    const Uint8* p = in + fixed;
+    for (int l = 0; l < 3; l++) {
+        lists[l]->clear();
+        for (size_t i = 0; i < counts[l]; i++, p += 2) {
+            int cell = (int)getLE(p, 2) % (GRID_COLS * GRID_ROWS);
+            lists[l]->push_back(cellPoint(cell));
+            world.cells[cell] |= flags[l];
+        }
+    }
+    world.layoutVersion++;
+    world.lastFreedCell = -1;
+    world.undoLog.clear();
+    world.foodStash.clear();
+    return true;
+}
+
+//-------------------------------------------------------
+//                    REPLAY RECORDER
+//-------------------------------------------------------
+// Streams a session to disk as it is played. record() only extends the
+// current run in the common case; finished packets collect in a small
+// buffer that is written out in blocks. Every keyframeInterval ticks a
+// full snapshot goes into the stream, and close() appends their index.
+class ReplayRecorder {
+public:
+    ReplayRecorder()
+        : file(nullptr),
+          pending(0),
+          written(0),
+          runCode(-1),
+          runLength(0),
+          literalCount(0),
+          ticks(0),
+          keyframeInterval(0),
+          nextKeyframe(0)
+    {
+    }
+
+    ~ReplayRecorder() {
+        close();
+    }
+
+    bool isOpen() const { return file != nullptr; }
+    Uint64 tickCount() const { return ticks; }
+
+    bool open(const std::string& path, const ReplayHeader& header) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        if (!file) {
+            return false;
+        }
+        std::vector<Uint8> out;
+        out.insert(out.end(), {'C', 'S', 'N', 'R'});
+        putLE(out, REPLAY_VERSION, 2);
+        putLE(out, REPLAY_HEADER_SIZE, 2);
+        putLE(out, header.seed, 8);
+        putLE(out, header.cols, 2);
+        putLE(out, header.rows, 2);
+        putLE(out, header.numFoodItems, 2);
+        putLE(out, header.numObstacles, 2);
+        putLE(out, header.gameMode, 1);
+        putLE(out, 0, 1);
+        putLE(out, (Uint16)header.snakeSpeed, 2);
+        putLE(out, header.keyframeInterval, 4);
+        std::fwrite(out.data(), 1, out.size(), file);
+
+        pending      = 0;
+        written      = out.size();
+        runCode      = -1;
+        runLength    = 0;
+        literalCount = 0;
+        ticks        = 0;
+        keyframeInterval = header.keyframeInterval;
+        nextKeyframe     = keyframeInterval > 0 ? keyframeInterval : ~(Uint64)0;
+        index.clear();
+        return true;
+    }
+
+    // Log the direction the world is about to step with. Call it before
+    // step(), once any collision from the previous tick has been handled.
+    void record(const GameWorld& world) {
+        if (!file) {
+            return;
+        }
+        if (ticks == nextKeyframe) {
+            writeKeyframe(world);
+        }
+        ticks++;
+        int code = directionCode(world.direction);
+        if (code == runCode) {
+            runLength++;
+            return;
+        }
+        endRun();
+        runCode   = code;
+        runLength = 1;
+    }
+
+    // Flush pending moves, write the end marker and close the file.
+    void close() {
+        if (!file) {
+            return;
+        }
+        endRun();
+        flushLiterals();
+        put(REPLAY_END);
+
+        size_t indexOffset = written;
+        std::vector<Uint8> out;
+        for (const ReplayKeyframe& k : index) {
+            putLE(out, k.tick, 8);
+            putLE(out, k.offset, 8);
+        }
+        putLE(out, indexOffset, 8);
+        putLE(out, index.size(), 4);
+        out.insert(out.end(), {'C', 'S', 'N', 'I'});
+        for (Uint8 b : out) {
+            put(b);
+        }
+        flushBuffer();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+private:
+    static const int BUFFER_SIZE = 4096;
+
+    FILE*  file;
+    Uint8  buffer[BUFFER_SIZE];
+    int    pending;
+    size_t written;         // bytes handed to put() so far, incl. header
+    int    runCode;
+    int    runLength;
+    Uint8  literals[REPLAY_MAX_LITERAL];
+    int    literalCount;
+    Uint64 ticks;
+
+    Uint32 keyframeInterval;
+    Uint64 nextKeyframe;
+    std::vector<ReplayKeyframe> index;
+    std::vector<Uint8>          snapshot;
+
+    // Close off pending moves so the keyframe sits exactly at this tick.
+    void writeKeyframe(const GameWorld& world) {
+        endRun();
+        flushLiterals();
+        snapshot.clear();
+        encodeKeyframe(snapshot, world, ticks);
+        index.push_back({ticks, written});
+        put(REPLAY_KEYFRAME);
+        for (int i = 0; i < 4; i++) {
+            put((Uint8)(snapshot.size() >> (8 * i)));
+        }
+        for (Uint8 b : snapshot) {
+            put(b);
+        }
+        nextKeyframe += keyframeInterval;
+    }
+
+    // The current run is over: emit it as run packets if it is long
+    // enough, otherwise queue its moves as literals.
+    void endRun() {
+        if (runLength >= REPLAY_MIN_RUN) {
+            flushLiterals();
+            while (runLength > 0) {
+                int n = (runLength > REPLAY_MAX_RUN) ? REPLAY_MAX_RUN : runLength;
+                put((Uint8)((runCode << 5) | (n - 1)));
+                runLength -= n;
+            }
+        } else {
+            for (; runLength > 0; runLength--) {
+                literals[literalCount++] = (Uint8)runCode;
+                if (literalCount == REPLAY_MAX_LITERAL) {
+                    flushLiterals();
+                }
+            }
+        }
+        runLength = 0;
+    }
+
+    void flushLiterals() {
+        if (literalCount == 0) {
+            return;
+        }
+        put((Uint8)(REPLAY_LITERAL | (literalCount - 1)));
+        for (int i = 0; i < literalCount; i += 4) {
+            Uint8 packed = 0;
+            for (int j = i; j < i + 4 && j < literalCount; j++) {
+                packed |= literals[j] << (2 * (j - i));
+            }
+            put(packed);
+        }
+        literalCount = 0;
+    }
+
+    void put(Uint8 byte) {
+        if (pending == BUFFER_SIZE) {
+            flushBuffer();
+        }
+        buffer[pending++] = byte;
+        written++;
+    }
+
+    void flushBuffer() {
+        std::fwrite(buffer, 1, pending, file);
+        pending = 0;
+    }
+};
+
+//-------------------------------------------------------
+//                     REPLAY READER
+//-------------------------------------------------------
+// Decodes a memory-mapped replay, one move at a time, and finds its
+// keyframes for seeking. Nothing is copied out of the mapping and decoding
+// never allocates.
+class ReplayReader {
+public:
+    ReplayReader()
+        : data(nullptr),
+          length(0),
+          headerSize(REPLAY_HEADER_SIZE),
+          pos(0),
+          runCode(0),
+          runLeft(0),
+          literalPos(0),
+          literalIndex(0),
+          literalLeft(0)
+    {
+    }
+
+    bool load(const std::string& path) {
+        if (!mapping.open(path)) {
+            data   = nullptr;
+            length = 0;
+            return false;
+        }
+        data   = mapping.data();
+        length = mapping.size();
+        return parseHeader();
+    }
+
+    // Size of the whole file in bytes.
+    size_t fileSize() const { return length; }
+
+    // Add up the moves in each direction from the current position to the
+    // end, a packet at a time. Much cheaper than next() per move when only
+    // totals are needed. Leaves the reader at the end of the stream.
+    Uint64 countMoves(Uint64 counts[4]) {
+        Uint64 local[4] = {0, 0, 0, 0};
+        while (runLeft > 0 || literalLeft > 0) {
+            local[next()]++;
+        }
+
+        // The hot loop keeps four 16-bit counters packed in one register
+        // and spills them before any lane can overflow: a packet adds at
+        // most 64 to a lane.
+        // Work on locals: stores through a byte pointer would otherwise make
+        // the compiler reload every member on each packet.
+        const Uint64* byteCounts = literalByteCounts();
+        const Uint8*  p   = data + pos;
+        const Uint8*  end = data + length;
+        const int SPILL_EVERY = 1000;
+        Uint64 packed = 0;
+        int packets = 0;
+        while (p < end) {
+            Uint8 packet = *p;
+            if ((packet & 0x80) == 0) {
+                packed += (Uint64)((packet & 0x1F) + 1) << (16 * (packet >> 5));
+                p++;
+            } else if ((packet & REPLAY_MARKER) == REPLAY_LITERAL) {
+                int n = (packet & 0x3F) + 1;
+                int bytes = (n + 3) / 4;
+                if (bytes >= end - p) {
+                    break;
+                }
+                // Count every byte whole; the zero padding in the last one
+                // reads as extra east moves, taken off again below.
+                const Uint8* moves = p + 1;
+                for (int i = 0; i < bytes; i++) {
+                    packed += byteCounts[moves[i]];
+                }
+                packed -= (Uint64)(bytes * 4 - n);
+                p += 1 + bytes;
+            } else if (packet == REPLAY_KEYFRAME && end - p >= 5) {
+                size_t size = (size_t)getLE(p + 1, 4);
+                if (size >= (size_t)(end - p)) {
+                    break;
+                }
+                p += 5 + size;
+            } else {
+                break;
+            }
+            if (++packets == SPILL_EVERY) {
+                spill(local, packed);
+                packets = 0;
+            }
+        }
+        spill(local, packed);
+        pos = length;
+
+        Uint64 total = 0;
+        for (int k = 0; k < 4; k++) {
+            counts[k] += local[k];
+            total     += local[k];
+        }
+        return total;
+    }
+
+    const ReplayHeader& info() const { return header; }
+    const std::vector<ReplayKeyframe>& keyframes() const { return index; }
+
+    // Load keyframe i into the world and continue reading right after it.
+    bool restore(size_t i, GameWorld& world) {
+        if (i >= index.size()) {
+            return false;
+        }
+        size_t at = index[i].offset;
+        if (at > length || length - at < 5) {
+            return false;
+        }
+        size_t size = (size_t)getLE(&data[at + 1], 4);
+        if (size > length - at - 5 || !decodeKeyframe(&data[at + 5], size, world)) {
+            return false;
+        }
+        pos         = at + 5 + size;
+        runLeft     = 0;
+        literalLeft = 0;
+        return true;
+    }
+
+    // Go back to the first move.
+    void rewind() {
+        pos         = headerSize;
+        runLeft     = 0;
+        literalLeft = 0;
+    }
+
+    // Next move code (0..3), or -1 at the end of the stream.
+    int next() {
+        if (runLeft > 0) {
+            runLeft--;
+            return runCode;
+        }
+        if (literalLeft > 0) {
+            return nextLiteral();
+        }
+        if (pos >= length) {
+            return -1;
+        }
+        Uint8 packet = data[pos];
+        if ((packet & 0x80) == 0) {
+            pos++;
+            runCode = packet >> 5;
+            runLeft = (packet & 0x1F) + 1;
+            return next();
+        }
+        if (packet == REPLAY_KEYFRAME) {
+            // Keyframes only matter when seeking; skip over them.
+            size_t size = (pos + 5 <= length) ? (size_t)getLE(&data[pos + 1], 4) : length;
+            pos = std::min(length, pos + 5 + size);
+            return next();
+        }
+        if ((packet & REPLAY_MARKER) == REPLAY_LITERAL) {
+            int count = (packet & 0x3F) + 1;
+            size_t bytes = (count + 3) / 4;
+            if (pos + 1 + bytes > length) {
+                pos = length;
+                return -1;
+            }
+            literalPos   = pos + 1;
+            literalIndex = 0;
+            literalLeft  = count;
+            pos         += 1 + bytes;
+            return nextLiteral();
+        }
+        // End marker (or anything this version does not know).
+        pos = length;
+        return -1;
+    }
+
+private:
+    MappedFile         mapping;
+    const Uint8*       data;
+    size_t             length;
+    ReplayHeader       header;
+    std::vector<ReplayKeyframe> index;
+    size_t             headerSize;
+    size_t             pos;
+    int                runCode;
+    int                runLeft;
+    size_t             literalPos;     // first payload byte of the literal
+    int                literalIndex;   // next move within the literal
+    int                literalLeft;
+
+    // Per literal byte, how many of its four moves go each way, as four
+    // 16-bit lanes.
+    static const Uint64* literalByteCounts() {
+        static const std::vector<Uint64> table = [] {
+            std::vector<Uint64> t(256, 0);
+            for (int b = 0; b < 256; b++) {
+                for (int i = 0; i < 4; i++) {
+                    t[b] += (Uint64)1 << (16 * ((b >> (2 * i)) & 3));
+                }
+            }
+            return t;
+        }();
+        return table.data();
+    }
+
+    static void spill(Uint64 local[4], Uint64& packed) {
+        for (int k = 0; k < 4; k++) {
+            local[k] += (packed >> (16 * k)) & 0xFFFF;
+        }
+        packed = 0;
+    }
+
+    int nextLiteral() {
+        int code = (data[literalPos + literalIndex / 4] >> (2 * (literalIndex % 4))) & 3;
+        literalIndex++;
+        literalLeft--;
+        return code;
+    }
+
+    bool parseHeader() {
+        if (length < REPLAY_HEADER_SIZE ||
+            data[0] != 'C' || data[1] != 'S' || data[2] != 'N' || data[3] != 'R') {
+            return false;
+        }
+        Uint16 version = (Uint16)getLE(&data[4], 2);
+        headerSize     = (size_t)getLE(&data[6], 2);
+        if (version < 1 || version > REPLAY_VERSION || headerSize > length) {
+            return false;
+        }
+        header.seed         = getLE(&data[8], 8);
+        header.cols         = (Uint16)getLE(&data[16], 2);
+        header.rows         = (Uint16)getLE(&data[18], 2);
+        header.numFoodItems = (Uint16)getLE(&data[20], 2);
+        header.numObstacles = (Uint16)getLE(&data[22], 2);
+        header.gameMode     = data[24];
+        header.snakeSpeed   = (Sint16)getLE(&data[26], 2);
+        header.keyframeInterval = (version >= 2) ? (Uint32)getLE(&data[28], 4) : 0;
+        if (hasTrailer()) {
+            if (!readIndex()) {
+                return false;
+            }
+        } else {
+            scanIndex();
+        }
+        rewind();
+        return true;
+    }
+
+    bool hasTrailer() const {
+        size_t n = length;
+        return n >= headerSize + REPLAY_TRAILER_SIZE &&
+               data[n - 4] == 'C' && data[n - 3] == 'S' && data[n - 2] == 'N' && data[n - 1] == 'I';
+    }
+
+    // Take the keyframe index from the trailer. Every entry must point at
+    // a whole keyframe packet of the tick it names, in order, ending
+    // before the next one (or the index); a file whose index does not
+    // hold up is not read at all.
+    bool readIndex() {
+        index.clear();
+        size_t n = length;
+        size_t offset = (size_t)getLE(&data[n - 16], 8);
+        size_t count  = (size_t)getLE(&data[n - 8], 4);
+        if (offset < headerSize || offset > n - REPLAY_TRAILER_SIZE ||
+            n - REPLAY_TRAILER_SIZE - offset != count * 16) {
+            return false;
+        }
+        size_t end = headerSize;
+        for (size_t i = 0; i < count; i++) {
+            ReplayKeyframe k = {getLE(&data[offset + i * 16], 8),
+                                (size_t)getLE(&data[offset + i * 16 + 8], 8)};
+            size_t limit = (i + 1 < count) ? (size_t)getLE(&data[offset + (i + 1) * 16 + 8], 8)
+                                           : offset;
+            if (k.offset < end || limit > offset || k.offset > limit || limit - k.offset < 5 ||
+                data[k.offset] != REPLAY_KEYFRAME) {
+                index.clear();
+                return false;
+            }
+            size_t size = (size_t)getLE(&data[k.offset + 1], 4);
+            if (size < 8 || size > limit - k.offset - 5 || getLE(&data[k.offset + 5], 8) != k.tick) {
+                index.clear();
+                return false;
+            }
+            end = k.offset + 5 + size;
+            index.push_back(k);
+        }
+        return true;
+    }
+
+    // No usable trailer: walk the packets and note every whole keyframe.
+    void scanIndex() {
+        index.clear();
+        size_t p = headerSize;
+        while (p < length) {
+            Uint8 packet = data[p];
+            if ((packet & 0x80) == 0) {
+                p++;
+            } else if (packet == REPLAY_KEYFRAME) {
+                if (p + 5 > length) {
+                    break;
+                }
+                size_t size = (size_t)getLE(&data[p + 1], 4);
+                if (p + 5 + size > length || size < 8) {
+                    break;
+                }
+                index.push_back({getLE(&data[p + 5], 8), p});
+                p += 5 + size;
+            } else if ((packet & REPLAY_MARKER) == REPLAY_LITERAL) {
+                p += 1 + ((packet & 0x3F) + 1 + 3) / 4;
+            } else {
+                break;
+            }
+        }
+    }
+};
+
+//-------------------------------------------------------
+//                     REPLAY PLAYER
+//-------------------------------------------------------
+// Feeds a replay's moves into a GameWorld tick by tick. The caller handles
+// collisions the same way live play does (by resetting the world), so the
+// session unfolds exactly as it was recorded.
+class ReplayPlayer {
+public:
+    ReplayPlayer()
+        : played(0),
+          done(true)
+    {
+    }
+
+    bool load(const std::string& path) {
+        done = true;
+        return reader.load(path);
+    }
+
+    const ReplayHeader& info() const { return reader.info(); }
+    Uint64 position() const { return played; }
+    size_t keyframeCount() const { return reader.keyframes().size(); }
+    bool   finished() const { return done; }
+
+    // Put the world back at tick 0 of the replay.
+    void start(GameWorld& world) {
+        const ReplayHeader& h = reader.info();
+        world.numFoodItems = h.numFoodItems;
+        world.numObstacles = h.numObstacles;
+        world.seed(h.seed);
+        world.reset();
+        reader.rewind();
+        played = 0;
+        done   = false;
+    }
+
+    // Play the next recorded tick. Returns NONE once the replay is over.
+    TickEvent advance(GameWorld& world) {
+        int code = reader.next();
+        if (code < 0) {
+            done = true;
+            return TickEvent::NONE;
+        }
+        played++;
+        world.direction = DIRECTIONS[code];
+        return world.step();
+    }
+
+    // Jump to the given tick: restore the nearest keyframe at or before it
+    // (unless the current position is already closer) and play forward.
+    void seek(GameWorld& world, Uint64 tick) {
+        const auto& keys = reader.keyframes();
+        auto after = std::upper_bound(keys.begin(), keys.end(), tick,
+            [](Uint64 t, const ReplayKeyframe& k) { return t < k.tick; });
+        Uint64 keyTick = (after == keys.begin()) ? 0 : (after - 1)->tick;
+
+        if (done || played > tick || played < keyTick) {
+            start(world);
+            if (after != keys.begin() && reader.restore(after - keys.begin() - 1, world)) {
+                played = keyTick;
+            }
+        }
+        while (played < tick && !done) {
+            TickEvent ev = advance(world);
+            if (ev == TickEvent::HIT_SELF || ev == TickEvent::HIT_OBSTACLE) {
+                world.reset();
+            }
+        }
+    }
+
+private:
+    ReplayReader reader;
+    Uint64       played;
+    bool         done;
+};
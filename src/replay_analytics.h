@@ -0,0 +1,255 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "game_world.h"
+#include "replay.h"
+#include "thread_pool.h"
+
+//-------------------------------------------------------
+//                    REPLAY EVENTS
+//-------------------------------------------------------
+enum class ReplayEventType {
+    ATE,
+    HIT_SELF,
+    HIT_OBSTACLE,
+    OBSTACLE_SPAWN
+};
+
+// Something that happened on a recorded tick (1-based). head is where the
+// snake's head was after the move, or where it crashed; spawn events also
+// give the new obstacle's cell.
+struct ReplayEvent {
+    Uint64          tick;
+    Point           head;
+    ReplayEventType type;
+    Point           obstacle;
+};
+
+// Plays a replay headlessly and hands out its events in order. The events
+// come from simulating the recorded moves, so this runs at simulation
+// speed; the world and event buffer are reused, so no tick allocates once
+// the world's vectors have grown.
+class ReplayEventCursor {
+public:
+    ReplayEventCursor()
+        : played(0),
+          pendingCount(0),
+          pendingNext(0),
+          done(true)
+    {
+    }
+
+    bool open(const std::string& path) {
+        if (!reader.load(path)) {
+            done = true;
+            return false;
+        }
+        const ReplayHeader& h = reader.info();
+        world.numFoodItems = h.numFoodItems;
+        world.numObstacles = h.numObstacles;
+        world.seed(h.seed);
+        world.reset();
+        played       = 0;
+        pendingCount = 0;
+        pendingNext  = 0;
+        done         = false;
+        return true;
+    }
+
+    const ReplayReader& replay() const { return reader; }
+    const GameWorld&    state() const { return world; }
+    Uint64              ticks() const { return played; }
+
+    // Next event, or false once the replay has run out.
+    bool next(ReplayEvent& out) {
+        while (pendingNext == pendingCount) {
+            if (done) {
+                return false;
+            }
+            advance();
+        }
+        out = pending[pendingNext++];
+        return true;
+    }
+
+private:
+    // One eat plus the obstacles it spawns is the most a tick produces.
+    static const int MAX_EVENTS_PER_TICK = 8;
+
+    ReplayReader reader;
+    GameWorld    world;
+    Uint64       played;
+    ReplayEvent  pending[MAX_EVENTS_PER_TICK];
+    int          pendingCount;
+    int          pendingNext;
+    bool         done;
+
+    void advance() {
+        pendingCount = 0;
+        pendingNext  = 0;
+        int code = reader.next();
+        if (code < 0) {
+            done = true;
+            return;
+        }
+        played++;
+        world.direction = DIRECTIONS[code];
+        const size_t obstaclesBefore = world.obstacles.size();
+        MovePlan plan = world.planMove();
+        TickEvent ev  = world.resolveMove(plan);
+
+        switch (ev) {
+            case TickEvent::ATE:
+                push(ReplayEventType::ATE, plan.newHead, {0, 0});
+                for (size_t i = obstaclesBefore; i < world.obstacles.size() &&
+                                                 pendingCount < MAX_EVENTS_PER_TICK; i++) {
+                    push(ReplayEventType::OBSTACLE_SPAWN, plan.newHead, world.obstacles[i]);
+                }
+                break;
+            case TickEvent::HIT_SELF:
+                push(ReplayEventType::HIT_SELF, plan.newHead, {0, 0});
+                world.reset();
+                break;
+            case TickEvent::HIT_OBSTACLE:
+                push(ReplayEventType::HIT_OBSTACLE, plan.newHead, {0, 0});
+                world.reset();
+                break;
+            default:
+                break;
+        }
+    }
+
+    void push(ReplayEventType type, Point head, Point obstacle) {
+        pending[pendingCount++] = {played, head, type, obstacle};
+    }
+};
+
+//-------------------------------------------------------
+//                   REPLAY ANALYTICS
+//-------------------------------------------------------
+// Totals over one or many replays. Every game that ended in a crash counts
+// towards the score histogram; a game still running when the recording
+// stopped does not.
+struct ReplayStats {
+    Uint64 files;
+    Uint64 badFiles;
+    Uint64 bytes;
+    Uint64 ticks;
+    Uint64 games;
+    Uint64 food;
+    Uint64 obstacleSpawns;
+    Uint64 deathsSelf;
+    Uint64 deathsObstacle;
+    std::map<int, Uint64> scores;    // final score -> games
+
+    ReplayStats()
+        : files(0), badFiles(0), bytes(0), ticks(0), games(0), food(0),
+          obstacleSpawns(0), deathsSelf(0), deathsObstacle(0)
+    {
+    }
+
+    void merge(const ReplayStats& other) {
+        files          += other.files;
+        badFiles       += other.badFiles;
+        bytes          += other.bytes;
+        ticks          += other.ticks;
+        games          += other.games;
+        food           += other.food;
+        obstacleSpawns += other.obstacleSpawns;
+        deathsSelf     += other.deathsSelf;
+        deathsObstacle += other.deathsObstacle;
+        for (const auto& s : other.scores) {
+            scores[s.first] += s.second;
+        }
+    }
+};
+
+inline ReplayStats analyzeReplay(const std::string& path) {
+    ReplayStats stats;
+    ReplayEventCursor cursor;
+    if (!cursor.open(path)) {
+        stats.badFiles = 1;
+        return stats;
+    }
+    stats.files = 1;
+    stats.bytes = cursor.replay().fileSize();
+
+    int score = 0;
+    ReplayEvent ev;
+    while (cursor.next(ev)) {
+        switch (ev.type) {
+            case ReplayEventType::ATE:
+                stats.food++;
+                score++;
+                break;
+            case ReplayEventType::OBSTACLE_SPAWN:
+                stats.obstacleSpawns++;
+                break;
+            case ReplayEventType::HIT_SELF:
+            case ReplayEventType::HIT_OBSTACLE:
+                if (ev.type == ReplayEventType::HIT_SELF) {
+                    stats.deathsSelf++;
+                } else {
+                    stats.deathsObstacle++;
+                }
+                stats.games++;
+                stats.scores[score]++;
+                score = 0;
+                break;
+        }
+    }
+    stats.ticks = cursor.ticks();
+    return stats;
+}
+
+// Analyze many files on a thread pool, one job per file.
+inline ReplayStats analyzeReplays(const std::vector<std::string>& paths, ThreadPool& pool) {
+    std::vector<ReplayStats> perFile(paths.size());
+    for (size_t i = 0; i < paths.size(); i++) {
+        pool.submit([&paths, &perFile, i] { perFile[i] = analyzeReplay(paths[i]); });
+    }
+    pool.wait();
+    ReplayStats total;
+    for (const auto& s : perFile) {
+        total.merge(s);
+    }
+    return total;
+}
+
+// Move totals only: no simulation, just the packet stream.
+struct ReplayMoveStats {
+    Uint64 files;
+    Uint64 bytes;
+    Uint64 moves;
+    Uint64 byDirection[4];
+};
+
+inline ReplayMoveStats countReplayMoves(const std::vector<std::string>& paths, ThreadPool& pool) {
+    std::vector<ReplayMoveStats> perFile(paths.size(), ReplayMoveStats{0, 0, 0, {0, 0, 0, 0}});
+    for (size_t i = 0; i < paths.size(); i++) {
+        pool.submit([&paths, &perFile, i] {
+            ReplayReader reader;
+            ReplayMoveStats& s = perFile[i];
+            if (reader.load(paths[i])) {
+                s.files = 1;
+                s.bytes = reader.fileSize();
+                s.moves = reader.countMoves(s.byDirection);
+            }
+        });
+    }
+    pool.wait();
+    ReplayMoveStats total = {0, 0, 0, {0, 0, 0, 0}};
+    for (const auto& s : perFile) {
+        total.files += s.files;
+        total.bytes += s.bytes;
+        total.moves += s.moves;
+        for (int k = 0; k < 4; k++) {
+            total.byDirection[k] += s.byDirection[k];
+        }
+    }
+    return total;
+}
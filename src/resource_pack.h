@@ -0,0 +1,220 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "byte_io.h"
+
+// tools/pack_resources.py writes the assets into this file as a byte array.
+// Builds without it load every asset by relative path, as before.
+#if defined(__has_include)
+#if __has_include("resource_pack.inc")
+#include "resource_pack.inc"
+#define HAVE_RESOURCE_PACK 1
+#endif
+#endif
+
+//-------------------------------------------------------
+//                  RESOURCE PACK FORMAT
+//-------------------------------------------------------
+// "CSNP", u16 version, u16 entry count, then one directory entry per file:
+//    u16 name length, name, u32 data offset, u32 packed size,
+//    u32 unpacked size, u32 crc of the unpacked bytes
+// followed by the packed data. Each file is one LZ block in the format
+// lzDecompress() reads.
+
+const Uint16 RESOURCE_PACK_VERSION = 1;
+
+// Environment variable naming a directory whose files replace packed ones.
+const char* const RESOURCE_OVERRIDE_ENV = "CSNAKE_ASSETS";
+
+// Decode an LZ block of sequences, each a token byte (literal count in the
+// high nibble, match length - 4 in the low one; 15 means more length bytes
+// follow, 255 at a time), the literals, then a u16 back-reference offset and
+// any extra match length. The last sequence has literals only. Returns false
+// on anything malformed rather than reading or writing out of bounds.
+inline bool lzDecompress(const Uint8* in, size_t inSize, Uint8* out, size_t outSize) {
+    const Uint8* end = in + inSize;
+    size_t pos = 0;
+    auto readLength = [&](size_t& n) {
+        Uint8 b;
+        do {
+            if (in == end) {
+                return false;
+            }
+            b = *in++;
+            n += b;
+        } while (b == 255);
+        return true;
+    };
+
+    while (in < end) {
+        Uint8 token = *in++;
+        size_t literals = token >> 4;
+        if (literals == 15 && !readLength(literals)) {
+            return false;
+        }
+        if (literals > (size_t)(end - in) || literals > outSize - pos) {
+            return false;
+        }
+        std::memcpy(out + pos, in, literals);
+        in  += literals;
+        pos += literals;
+        if (in == end) {
+            break;
+        }
+
+        if (end - in < 2) {
+            return false;
+        }
+        size_t offset = (size_t)getLE(in, 2);
+        in += 2;
+        size_t length = token & 15;
+        if (length == 15 && !readLength(length)) {
+            return false;
+        }
+        length += 4;
+        if (offset == 0 || offset > pos || length > outSize - pos) {
+            return false;
+        }
+        // Byte by byte: the match may overlap what it is copying.
+        const Uint8* from = out + pos - offset;
+        for (size_t i = 0; i < length; i++) {
+            out[pos + i] = from[i];
+        }
+        pos += length;
+    }
+    return pos == outSize;
+}
+
+//-------------------------------------------------------
+//                     RESOURCE PACK
+//-------------------------------------------------------
+// Hands out assets as SDL_RWops. Lookup order for a name:
+//   1. the override directory, if one is set (for mods),
+//   2. the pack linked into the executable,
+//   3. the file of that name in the working directory.
+// Packed files are unpacked on first use and kept for the life of the
+// process, since SDL_ttf reads from a font's RWops for as long as the font
+// is open. Safe to use from the asset loader and the main thread at once.
+class ResourcePack {
+public:
+    ResourcePack() {
+#ifdef HAVE_RESOURCE_PACK
+        parse(RESOURCE_PACK_DATA, sizeof(RESOURCE_PACK_DATA));
+#endif
+        if (const char* dir = std::getenv(RESOURCE_OVERRIDE_ENV)) {
+            overrideDir = dir;
+        }
+    }
+
+    void setOverrideDir(const std::string& dir) {
+        std::lock_guard<std::mutex> lock(mutex);
+        overrideDir = dir;
+    }
+
+    bool embedded() const { return !entries.empty(); }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> out;
+        for (const auto& e : entries) {
+            out.push_back(e.first);
+        }
+        return out;
+    }
+
+    // A fresh RWops for the named asset, or null if it is nowhere to be
+    // found. Pass freesrc = 1 to whatever consumes it.
+    SDL_RWops* open(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!overrideDir.empty()) {
+            std::string path = overrideDir + "/" + name;
+            std::error_code ec;
+            if (std::filesystem::is_regular_file(path, ec)) {
+                return SDL_RWFromFile(path.c_str(), "rb");
+            }
+        }
+        auto it = entries.find(name);
+        if (it == entries.end()) {
+            return SDL_RWFromFile(name.c_str(), "rb");
+        }
+        Entry& e = it->second;
+        if (!e.unpacked && !unpack(e)) {
+            return nullptr;
+        }
+        return SDL_RWFromConstMem(e.data.data(), (int)e.data.size());
+    }
+
+private:
+    struct Entry {
+        const Uint8*       packed;
+        size_t             packedSize;
+        size_t             size;
+        Uint32             crc;
+        bool               unpacked;
+        std::vector<Uint8> data;
+    };
+
+    std::mutex                   mutex;
+    std::string                  overrideDir;
+    std::map<std::string, Entry> entries;
+
+    // Read the directory; a pack that fails any check is ignored whole.
+    void parse(const Uint8* blob, size_t size) {
+        if (size < 8 || blob[0] != 'C' || blob[1] != 'S' || blob[2] != 'N' || blob[3] != 'P' ||
+            getLE(blob + 4, 2) != RESOURCE_PACK_VERSION) {
+            return;
+        }
+        size_t count = (size_t)getLE(blob + 6, 2);
+        size_t at = 8;
+        std::map<std::string, Entry> found;
+        for (size_t i = 0; i < count; i++) {
+            if (size - at < 2) {
+                return;
+            }
+            size_t nameLength = (size_t)getLE(blob + at, 2);
+            at += 2;
+            if (size - at < nameLength + 16) {
+                return;
+            }
+            std::string name((const char*)blob + at, nameLength);
+            at += nameLength;
+            Entry e;
+            size_t offset = (size_t)getLE(blob + at, 4);
+            e.packedSize  = (size_t)getLE(blob + at + 4, 4);
+            e.size        = (size_t)getLE(blob + at + 8, 4);
+            e.crc         = (Uint32)getLE(blob + at + 12, 4);
+            e.unpacked    = false;
+            at += 16;
+            if (offset > size || e.packedSize > size - offset) {
+                return;
+            }
+            e.packed = blob + offset;
+            found[name] = e;
+        }
+        entries.swap(found);
+    }
+
+    bool unpack(Entry& e) {
+        e.data.resize(e.size);
+        if (!lzDecompress(e.packed, e.packedSize, e.data.data(), e.size) ||
+            crc32(e.data.data(), e.size) != e.crc) {
+            e.data.clear();
+            return false;
+        }
+        e.unpacked = true;
+        return true;
+    }
+};
+
+// The process-wide pack.
+inline ResourcePack& resources() {
+    static ResourcePack pack;
+    return pack;
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <deque>
+#include <memory>
+
+#include "game_world.h"
+
+// Default rewind history, in ticks (about 17 minutes at the default speed).
+const size_t DEFAULT_REWIND_TICKS = 10000;
+
+//-------------------------------------------------------
+//                     REWIND BUFFER
+//-------------------------------------------------------
+// Bounded history for stepping a live game backwards. The per-tick deltas
+// are the world's own undo records (head added, tail removed, food and
+// obstacles replaced), so recording costs one fixed-size push per tick.
+//
+// A reset clears the world's log, so each finished game is parked here as
+// a segment: the world as it was just before the reset, holding that
+// game's undo log. Rewinding past the start of the current game resumes
+// from the parked state and keeps undoing into it.
+//
+// Once the history is more than a quarter over capacity, the oldest
+// records are dropped in one go, which keeps the cost per tick constant
+// on average.
+class RewindBuffer {
+public:
+    explicit RewindBuffer(size_t capacityTicks = DEFAULT_REWIND_TICKS)
+        : limit(capacityTicks),
+          parkedRecords(0)
+    {
+    }
+
+    size_t capacity() const { return limit; }
+
+    void setCapacity(size_t ticks) {
+        limit = ticks;
+    }
+
+    // Ticks that can currently be rewound.
+    size_t available(const GameWorld& world) const {
+        return world.undoLog.size() + parkedRecords;
+    }
+
+    // Finished games parked in the history, which a rewind can go back into.
+    size_t parkedGames() const {
+        return parked.size();
+    }
+
+    // Approximate heap use of the history, in bytes.
+    size_t memoryUse(const GameWorld& world) const {
+        size_t bytes = world.undoLog.capacity() * sizeof(UndoRecord) +
+                       world.foodStash.capacity() * sizeof(Point);
+        for (const auto& s : parked) {
+            bytes += sizeof(GameWorld) +
+                     s->undoLog.capacity() * sizeof(UndoRecord) +
+                     s->foodStash.capacity() * sizeof(Point) +
+                     s->cells.capacity() +
+                     (s->snake.capacity() + s->foodItems.capacity() +
+                      s->obstacles.capacity()) * sizeof(Point);
+        }
+        return bytes;
+    }
+
+    // Start recording a new session in this world, forgetting any history.
+    void start(GameWorld& world) {
+        parked.clear();
+        parkedRecords = 0;
+        world.undoLog.clear();
+        world.foodStash.clear();
+        world.undoLog.reserve(limit + limit / 4 + 1);
+        world.recordUndo = limit > 0;
+    }
+
+    // Stop recording and drop the history.
+    void stop(GameWorld& world) {
+        parked.clear();
+        parkedRecords = 0;
+        world.recordUndo = false;
+        world.undoLog.clear();
+        world.foodStash.clear();
+    }
+
+    // Call after every step() of the live world.
+    void afterStep(GameWorld& world) {
+        if (available(world) > limit + limit / 4) {
+            trim(world, available(world) - limit);
+        }
+    }
+
+    // Call just before world.reset(), to keep the finished game reachable.
+    void beforeReset(GameWorld& world) {
+        if (!world.recordUndo) {
+            return;
+        }
+        // A right-sized copy: the full reservation stays with the live
+        // world, so a short game parks only what it used.
+        std::unique_ptr<GameWorld> seg(new GameWorld());
+        seg->copyStateFrom(world);
+        seg->undoLog.assign(world.undoLog.begin(), world.undoLog.end());
+        seg->foodStash.assign(world.foodStash.begin(), world.foodStash.end());
+        world.undoLog.clear();
+        world.foodStash.clear();
+        parkedRecords += seg->undoLog.size();
+        parked.push_back(std::move(seg));
+    }
+
+    // Step the world back by up to ticks; returns how far it went.
+    size_t rewind(GameWorld& world, size_t ticks) {
+        size_t done = 0;
+        while (done < ticks) {
+            if (world.undoLog.empty()) {
+                if (parked.empty()) {
+                    break;
+                }
+                // Back into the previous game, as it was before its reset.
+                GameWorld& seg = *parked.back();
+                world.copyStateFrom(seg);
+                world.undoLog.assign(seg.undoLog.begin(), seg.undoLog.end());
+                world.foodStash.assign(seg.foodStash.begin(), seg.foodStash.end());
+                parkedRecords -= world.undoLog.size();
+                parked.pop_back();
+                continue;
+            }
+            size_t n = std::min(ticks - done, world.undoLog.size());
+            world.rewindTo(world.undoLog.size() - n);
+            done += n;
+        }
+        return done;
+    }
+
+private:
+    size_t limit;
+    std::deque<std::unique_ptr<GameWorld>> parked;    // oldest first
+    size_t parkedRecords;
+
+    // Forget the oldest count ticks of history.
+    void trim(GameWorld& world, size_t count) {
+        while (count > 0 && !parked.empty()) {
+            GameWorld& oldest = *parked.front();
+            if (oldest.undoLog.size() <= count) {
+                count         -= oldest.undoLog.size();
+                parkedRecords -= oldest.undoLog.size();
+                parked.pop_front();
+            } else {
+                oldest.dropOldestUndo(count);
+                parkedRecords -= count;
+                count = 0;
+            }
+        }
+        if (count > 0) {
+            world.dropOldestUndo(count);
+        }
+    }
+};
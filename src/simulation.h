@@ -0,0 +1,795 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "audio.h"
+#include "autopilot.h"
+#include "field_of_view.h"
+#include "game_world.h"
+#include "hamiltonian.h"
+#include "input_queue.h"
+#include "light_map.h"
+#include "lookahead.h"
+#include "replay.h"
+#include "rewind.h"
+#include "snake_runs.h"
+#include "spsc_ring.h"
+#include "stats_store.h"
+#include "triple_buffer.h"
+
+//-------------------------------------------------------
+//                  SIMULATION SETTINGS
+//-------------------------------------------------------
+// Every live session is recorded here.
+const char* const REPLAY_DIR = "replays";
+
+// Finished games and the high score are kept here.
+const char* const STATS_DIR = "stats";
+
+// Playback speed limits, in recorded ticks per snake-speed interval.
+const int MAX_PLAYBACK_SPEED = 1024;
+
+// How far PAGEUP / PAGEDOWN jump during playback.
+const Uint64 REPLAY_SEEK_TICKS = 500;
+
+// While the rewind key is held, ticks taken back per snake-speed interval.
+const int REWIND_TICKS_PER_STEP = 2;
+
+// Commands the render thread can queue before the simulation catches up.
+const size_t SIM_COMMAND_QUEUE = 256;
+
+// The simulation thread sleeps at most this long when nothing is due.
+const Uint32 SIM_IDLE_WAIT_MS = 100;
+
+// Which computer player, if any, steers the snake.
+enum class PilotMode {
+    OFF,
+    SEARCH,     // BFS to nearest food with a tail-reachability check
+    CYCLE,      // Hamiltonian tour with shortcuts
+    LOOKAHEAD   // depth-limited search over the game rules
+};
+
+// Enumeration for game modes.
+enum class GameMode {
+    NORMAL,
+    FLASHLIGHT,   // only a disc around the head is lit
+    SHADOWS       // the same disc, with obstacles casting shadows
+};
+
+// How many grid blocks from the snake's head the light reaches.
+const int FLASHLIGHT_RADIUS_BLOCKS = 5;
+
+// Lights in the FLASHLIGHT and SHADOWS modes (see Light). The head's is
+// over-bright so the middle of the disc is fully lit; food and obstacles
+// glow faintly around themselves.
+const Light HEAD_LIGHT     = {0, 0, FLASHLIGHT_RADIUS_BLOCKS + 0.5f, 1.6f};
+const Light FOOD_LIGHT     = {0, 0, 2.5f, 0.9f};
+const Light OBSTACLE_LIGHT = {0, 0, 1.5f, 0.5f};
+
+struct Sparkle {
+    float x, y;
+    float life;
+};
+
+// How the snake's ends moved on the last tick, so that frames between
+// ticks can draw them part of the way. Only set after a single plain
+// move; otherwise the snapshot is drawn as it is.
+struct SnakeMotion {
+    bool   moving;
+    bool   tailMoved;     // false when it ate and the tail stayed put
+    Point  headDir;       // in cells, from the old head to the new one
+    Point  tailFrom;      // the cell the tail left
+    Point  tailDir;       // in cells, from tailFrom to the new tail
+    Uint64 at;            // SDL_GetPerformanceCounter() at the tick
+    Uint64 interval;      // performance counter ticks until the next one
+};
+
+// Settings a new game starts with.
+struct SessionConfig {
+    int       snakeSpeed;
+    int       numFoodItems;
+    int       numObstacles;
+    int       rewindTicks;
+    GameMode  gameMode;
+    PilotMode pilot;
+};
+
+// A game ended by a collision, with where it started so that rewinding
+// into it can carry on from there.
+struct FinishedGame {
+    GameRecord record;
+    Uint64     startTicks;
+    Uint32     startTime;
+};
+
+//-------------------------------------------------------
+//                 COMMANDS & SNAPSHOTS
+//-------------------------------------------------------
+enum class SimCommandType {
+    START_GAME,       // config
+    LEAVE_GAME,
+    PAUSE,
+    RESUME,
+    TURN,             // direction, at
+    SET_PILOT,        // config.pilot
+    REWIND,           // value: 1 while the key is held, 0 on release
+    PLAYBACK_FASTER,
+    PLAYBACK_SLOWER,
+    SEEK,             // value: ticks forward (negative for back)
+    RESTART_REPLAY,
+    QUIT
+};
+
+struct SimCommand {
+    SimCommandType type;
+    int            value;
+    Point          direction;
+    SessionConfig  config;
+    Uint64         at;          // SDL_GetPerformanceCounter() at the key press
+};
+
+// What the render thread draws: a copy of everything visible, taken after
+// each change. Never touched by the simulation once published.
+struct GameSnapshot {
+    Uint64 sequence;          // bumps on every publish
+    Uint64 ticks;             // world ticks so far
+    bool   active;            // a game or playback is running
+    bool   replaying;
+    bool   rewinding;
+    int    score;
+    int    highScore;
+    int    playbackSpeed;
+    Uint64 replayPosition;
+    size_t rewindAvailable;
+    Uint32 finishedPlaybacks; // playbacks that ran to the end
+    PilotMode pilot;
+    std::vector<SDL_Rect> snakeRects;    // one per straight run, see SnakeRuns
+    Point                snakeHead;
+    size_t               snakeLength;
+    SnakeMotion          motion;
+    std::vector<Point>   foodItems;
+    std::vector<Point>   obstacles;
+    std::vector<Uint8>   cells;          // world.cells: CELL_* per grid cell
+    std::vector<Uint8>   light;          // light modes: level per cell, else empty
+    std::vector<Sparkle> sparkles;
+
+    GameSnapshot()
+        : sequence(0), ticks(0), active(false), replaying(false), rewinding(false),
+          score(0), highScore(0), playbackSpeed(1), replayPosition(0),
+          rewindAvailable(0), finishedPlaybacks(0), pilot(PilotMode::OFF),
+          snakeHead({0, 0}), snakeLength(0),
+          motion({false, false, {0, 0}, {0, 0}, {0, 0}, 0, 0})
+    {
+    }
+};
+
+//-------------------------------------------------------
+//                 SIMULATION THREAD
+//-------------------------------------------------------
+// Runs the game on its own thread so tick timing does not depend on how
+// long frames take to draw or present. The render thread talks to it only
+// through a lock-free command queue in and a triple buffer of snapshots
+// out; everything else in here belongs to the simulation thread while it
+// runs. Before start() (and after stop()) the owner may set it up
+// directly: openStats(), loadReplay().
+class Simulation {
+public:
+    Simulation()
+        : audio(nullptr),
+          wake(nullptr),
+          soundOn(false),
+          running(false),
+          replayDir(REPLAY_DIR),
+          timeUpdates(false),
+          fov(GRID_COLS, GRID_ROWS),
+          lights(GRID_COLS, GRID_ROWS),
+          lightTicks(0),
+          lightLayout(0),
+          lightHead(-1),
+          config(),
+          active(false),
+          paused(false),
+          quit(false),
+          replaying(false),
+          rewinding(false),
+          playbackSpeed(1),
+          lastMoveTime(0),
+          highScore(0),
+          gameStartTicks(0),
+          gameStartTime(0),
+          finishedPlaybacks(0),
+          published(0),
+          updatesTimed(0),
+          updateCounts(0),
+          motion({false, false, {0, 0}, {0, 0}, {0, 0}, 0, 0})
+    {
+    }
+
+    ~Simulation() {
+        stop();
+    }
+
+    // Sound effects go here once enableSound() has been called.
+    void setAudio(AudioSystem* a) {
+        audio = a;
+    }
+
+    void enableSound() {
+        soundOn = true;
+    }
+
+    // Where live sessions are recorded; empty turns recording off.
+    void setReplayDir(const std::string& dir) {
+        replayDir = dir;
+    }
+
+    bool openStats(const std::string& dir) {
+        bool ok = stats.open(dir);
+        highScore = (int)stats.summary().bestScore;
+        return ok;
+    }
+
+    // Get a recorded session ready to play. Returns false if the file is
+    // not a replay this build can read.
+    bool loadReplay(const std::string& path) {
+        if (!player.load(path)) {
+            return false;
+        }
+        const ReplayHeader& h = player.info();
+        if (h.cols != GRID_COLS || h.rows != GRID_ROWS) {
+            return false;
+        }
+        config.gameMode = (h.gameMode <= (Uint8)GameMode::SHADOWS)
+                        ? (GameMode)h.gameMode : GameMode::NORMAL;
+        rewindBuffer.stop(world);
+        replaying     = true;
+        playbackSpeed = 1;
+        active        = true;
+        paused        = false;
+        player.start(world);
+        publish();
+        return true;
+    }
+
+    GameMode replayMode() const { return config.gameMode; }
+
+    void start() {
+        if (running) {
+            return;
+        }
+        wake    = SDL_CreateSemaphore(0);
+        quit    = false;
+        running = true;
+        thread  = std::thread(&Simulation::run, this);
+    }
+
+    void stop() {
+        if (!running) {
+            return;
+        }
+        send(SimCommandType::QUIT);
+        thread.join();
+        SDL_DestroySemaphore(wake);
+        wake    = nullptr;
+        running = false;
+    }
+
+    // Render-thread side. Never blocks unless the queue is full.
+    void send(const SimCommand& c) {
+        while (!commands.push(c)) {
+            SDL_Delay(1);
+        }
+        if (wake) {
+            SDL_SemPost(wake);
+        }
+    }
+
+    void send(SimCommandType type, int value = 0) {
+        send(SimCommand{type, value, {0, 0}, SessionConfig(), 0});
+    }
+
+    // Take the newest snapshot, if one has been published since last time.
+    bool refresh() {
+        return snapshots.update();
+    }
+
+    const GameSnapshot& snapshot() const {
+        return snapshots.readSlot();
+    }
+
+    // Turn counts and latencies. Only while stopped.
+    const TurnQueue& input() const {
+        return turns;
+    }
+
+    // Time each update(), for benchmarks. Set before start().
+    void setUpdateTiming(bool on) {
+        timeUpdates = on;
+    }
+
+    // Mean time of the updates timed so far. Only while stopped.
+    double meanUpdateMicros() const {
+        if (updatesTimed == 0) {
+            return 0.0;
+        }
+        return updateCounts * 1e6 / (double)SDL_GetPerformanceFrequency() / updatesTimed;
+    }
+
+private:
+    // Set up once, before start().
+    AudioSystem* audio;
+    SDL_sem*     wake;
+    std::atomic<bool> soundOn;
+    std::thread  thread;
+    bool         running;
+    std::string  replayDir;
+    bool         timeUpdates;
+
+    SpscRing<SimCommand, SIM_COMMAND_QUEUE> commands;
+    TripleBuffer<GameSnapshot>              snapshots;
+
+    // Simulation thread only from here on.
+    GameWorld     world;
+    SnakeRuns     snakeRuns;     // world.snake as rectangles, kept in step
+    FieldOfView   fov;           // SHADOWS mode, from the head
+    std::vector<int> wallCells;  // world.obstacles as cells, for fov
+    LightMap      lights;        // light modes; redone once per tick
+
+    // world.ticks, layoutVersion and head cell the light map was made for.
+    Uint64        lightTicks;
+    Uint32        lightLayout;
+    int           lightHead;
+    SessionConfig config;
+    bool          active;
+    bool          paused;
+    bool          quit;
+    bool          replaying;
+    bool          rewinding;
+    int           playbackSpeed;
+    Uint32        lastMoveTime;
+    int           highScore;
+
+    // Where the current game started, for its stats record.
+    Uint64        gameStartTicks;
+    Uint32        gameStartTime;
+    StatsStore    stats;
+
+    // Games ended by a collision whose segment is still parked in the
+    // rewind history, oldest first, one per parked game. A rewind into
+    // one plays it on, so each is logged only once it drops out of the
+    // history or the session ends.
+    std::deque<FinishedGame> unsettledGames;
+
+    // Direction keys waiting for their tick.
+    TurnQueue      turns;
+
+    Autopilot      autopilot;
+    HamiltonPilot  hamiltonPilot;
+    LookaheadPilot lookaheadPilot;
+
+    // Recording of the live session, and playback of a recorded one.
+    ReplayRecorder recorder;
+    ReplayPlayer   player;
+    Uint32         finishedPlaybacks;
+
+    // Hold R to step the live game backwards.
+    RewindBuffer   rewindBuffer;
+
+    std::vector<Sparkle> sparkles;
+    Uint64               published;
+    Uint64               updatesTimed;
+    Uint64               updateCounts; // performance counter ticks in update()
+    SnakeMotion          motion;      // of the last update()
+
+    // Milliseconds between ticks at the current speed.
+    int tickInterval() const {
+        return replaying ? player.info().snakeSpeed : config.snakeSpeed;
+    }
+
+    void run() {
+        while (!quit) {
+            bool changed = drainCommands();
+            if (quit) {
+                break;
+            }
+            Uint32 wait = SIM_IDLE_WAIT_MS;
+            if (active && !paused) {
+                Uint32 now = SDL_GetTicks();
+                int interval = tickInterval();
+                if (now - lastMoveTime >= (Uint32)interval) {
+                    lastMoveTime = now;
+                    if (timeUpdates) {
+                        Uint64 begin = SDL_GetPerformanceCounter();
+                        update();
+                        updateCounts += SDL_GetPerformanceCounter() - begin;
+                        updatesTimed++;
+                    } else {
+                        update();
+                    }
+                    changed = true;
+                }
+                Uint32 elapsed = SDL_GetTicks() - lastMoveTime;
+                if (elapsed < (Uint32)interval) {
+                    wait = std::min(wait, (Uint32)interval - elapsed);
+                } else {
+                    wait = 0;
+                }
+            }
+            if (changed) {
+                publish();
+            }
+            SDL_SemWaitTimeout(wake, wait);
+        }
+    }
+
+    bool drainCommands() {
+        bool changed = false;
+        SimCommand c;
+        while (commands.pop(c)) {
+            apply(c);
+            changed = true;
+        }
+        return changed;
+    }
+
+    void apply(const SimCommand& c) {
+        switch (c.type) {
+            case SimCommandType::START_GAME:
+                config = c.config;
+                startGame();
+                break;
+            case SimCommandType::LEAVE_GAME:
+                leaveGame();
+                break;
+            case SimCommandType::PAUSE:
+                paused = true;
+                break;
+            case SimCommandType::RESUME:
+                paused = false;
+                break;
+            case SimCommandType::TURN:
+                // While a pilot steers, keys do not reach the snake.
+                if (active && !replaying && config.pilot == PilotMode::OFF) {
+                    turns.push(TurnInput{c.direction, c.at}, world.direction);
+                }
+                break;
+            case SimCommandType::SET_PILOT:
+                config.pilot = c.config.pilot;
+                turns.clear();
+                break;
+            case SimCommandType::REWIND:
+                rewinding = c.value != 0 && active && !replaying;
+                break;
+            case SimCommandType::PLAYBACK_FASTER:
+                playbackSpeed = std::min(playbackSpeed * 2, MAX_PLAYBACK_SPEED);
+                break;
+            case SimCommandType::PLAYBACK_SLOWER:
+                playbackSpeed = std::max(playbackSpeed / 2, 1);
+                break;
+            case SimCommandType::SEEK:
+                if (replaying) {
+                    Uint64 at = player.position();
+                    Uint64 back = (Uint64)std::max(0, -c.value);
+                    Uint64 to = c.value >= 0 ? at + (Uint64)c.value
+                                             : (at > back ? at - back : 0);
+                    player.seek(world, to);
+                }
+                break;
+            case SimCommandType::RESTART_REPLAY:
+                if (replaying) {
+                    player.start(world);
+                }
+                break;
+            case SimCommandType::QUIT:
+                if (active) {
+                    leaveGame();
+                }
+                quit = true;
+                break;
+        }
+    }
+
+    void publish() {
+        GameSnapshot& s = snapshots.writeSlot();
+        s.sequence          = ++published;
+        s.ticks             = world.ticks;
+        s.active            = active;
+        s.replaying         = replaying;
+        s.rewinding         = rewinding;
+        s.score             = world.score;
+        s.highScore         = highScore;
+        s.playbackSpeed     = playbackSpeed;
+        s.replayPosition    = replaying ? player.position() : 0;
+        s.rewindAvailable   = rewinding ? rewindBuffer.available(world) : 0;
+        s.finishedPlaybacks = finishedPlaybacks;
+        s.pilot             = config.pilot;
+        snakeRuns.sync(world.snake);
+        snakeRuns.rects(s.snakeRects);
+        s.snakeHead         = world.snake.empty() ? Point{0, 0} : world.snake.front();
+        s.snakeLength       = world.snake.size();
+        s.motion            = motion;
+        s.foodItems.assign(world.foodItems.begin(), world.foodItems.end());
+        s.obstacles.assign(world.obstacles.begin(), world.obstacles.end());
+        s.cells.assign(world.cells.begin(), world.cells.end());
+        if (config.gameMode != GameMode::NORMAL && !world.snake.empty()) {
+            updateLightMap();
+            s.light.assign(lights.levels().begin(), lights.levels().end());
+        } else {
+            s.light.clear();
+            lightHead = -1;
+        }
+        s.sparkles.assign(sparkles.begin(), sparkles.end());
+        snapshots.publish();
+    }
+
+    // Shadows from the current obstacles. The view is cached, so publishing
+    // without a move costs only the wall check; a spawn that leaves the
+    // head where it was recasts just the octants the new walls fall in.
+    void updateFieldOfView() {
+        wallCells.clear();
+        for (const Point& p : world.obstacles) {
+            wallCells.push_back(cellIndex(p));
+        }
+        fov.setWalls(wallCells);
+        fov.update(cellIndex(world.snake.front()), FLASHLIGHT_RADIUS_BLOCKS);
+    }
+
+    // The head's light (blocked by obstacles in SHADOWS mode) plus a glow
+    // from every food item and obstacle. Publishes that do not move the
+    // world reuse the last map.
+    void updateLightMap() {
+        const int head = cellIndex(world.snake.front());
+        if (head == lightHead && world.ticks == lightTicks && world.layoutVersion == lightLayout) {
+            return;
+        }
+        lightHead   = head;
+        lightTicks  = world.ticks;
+        lightLayout = world.layoutVersion;
+
+        lights.clear();
+        const Uint8* mask = nullptr;
+        if (config.gameMode == GameMode::SHADOWS) {
+            updateFieldOfView();
+            mask = fov.visibility().data();
+        }
+        lights.add(placed(HEAD_LIGHT, world.snake.front()), mask);
+        for (const Point& p : world.foodItems) {
+            lights.add(placed(FOOD_LIGHT, p));
+        }
+        for (const Point& p : world.obstacles) {
+            lights.add(placed(OBSTACLE_LIGHT, p));
+        }
+        lights.finish();
+    }
+
+    static Light placed(Light l, const Point& p) {
+        l.x = p.x / GRID_SIZE;
+        l.y = p.y / GRID_SIZE;
+        return l;
+    }
+
+    //---------------------------------------------------
+    //             GAME UPDATE & LOGIC
+    //---------------------------------------------------
+    void update() {
+        // Where the ends were, to tell the renderer how they moved. Fast
+        // playback and rewind move more than a cell per tick; those are
+        // drawn as they are.
+        const bool single = !rewinding && (!replaying || playbackSpeed == 1);
+        const size_t lengthBefore = world.snake.size();
+        const Point  headBefore = lengthBefore ? world.snake.front() : Point{0, 0};
+        const Point  tailBefore = lengthBefore ? world.snake.back() : Point{0, 0};
+        motion.moving = false;
+
+        if (replaying) {
+            for (int i = 0; i < playbackSpeed && !player.finished(); i++) {
+                handleTick(player.advance(world));
+            }
+            if (player.finished()) {
+                finishedPlaybacks++;
+                leaveGame();
+                return;
+            }
+        } else if (rewinding) {
+            // A replay can only move forward, so taking ticks back ends
+            // this session's recording.
+            if (rewindBuffer.rewind(world, REWIND_TICKS_PER_STEP) > 0) {
+                recorder.close();
+            }
+            // Back into a finished game: it goes on from where it started.
+            while (unsettledGames.size() > rewindBuffer.parkedGames()) {
+                gameStartTicks = unsettledGames.back().startTicks;
+                gameStartTime  = unsettledGames.back().startTime;
+                unsettledGames.pop_back();
+            }
+        } else {
+            TurnInput t;
+            if (config.pilot == PilotMode::SEARCH) {
+                world.direction = autopilot.chooseDirection(world);
+            } else if (config.pilot == PilotMode::CYCLE) {
+                world.direction = hamiltonPilot.chooseDirection(world);
+            } else if (config.pilot == PilotMode::LOOKAHEAD) {
+                world.direction = lookaheadPilot.chooseDirection(world);
+            } else if (turns.pop(world.direction, t)) {
+                world.direction = t.direction;
+                turns.recordApplied(t, SDL_GetPerformanceCounter());
+            }
+            recorder.record(world);
+            handleTick(world.step());
+            rewindBuffer.afterStep(world);
+            settleGames();
+        }
+
+        if (single && lengthBefore > 0 && !world.snake.empty()) {
+            const size_t n = world.snake.size();
+            Point dir = stepDirection(headBefore, world.snake.front());
+            if ((dir.x != 0 || dir.y != 0) && (n == lengthBefore || n == lengthBefore + 1)) {
+                motion.moving    = true;
+                motion.tailMoved = n == lengthBefore;
+                motion.headDir   = dir;
+                motion.tailFrom  = tailBefore;
+                motion.tailDir   = stepDirection(tailBefore, world.snake.back());
+                motion.at        = SDL_GetPerformanceCounter();
+                motion.interval  = (Uint64)tickInterval() * SDL_GetPerformanceFrequency() / 1000;
+            }
+        }
+
+        for (auto &sp : sparkles) {
+            sp.life -= 0.05f;
+        }
+        sparkles.erase(std::remove_if(sparkles.begin(), sparkles.end(),
+            [](const Sparkle &s){return s.life <= 0.f;}), sparkles.end());
+    }
+
+    // Stereo position of the snake's head, for its sound effects.
+    float headPan() const {
+        return panForX((float)world.snake[0].x + GRID_SIZE / 2, (float)SCREEN_WIDTH);
+    }
+
+    void playSound(Sound sound) {
+        if (audio && soundOn) {
+            audio->post(sound, headPan());
+        }
+    }
+
+    void handleTick(TickEvent ev) {
+        snakeRuns.sync(world.snake);
+        switch (ev) {
+            case TickEvent::HIT_SELF:
+            case TickEvent::HIT_OBSTACLE:
+                handleCollision();
+                break;
+            case TickEvent::ATE:
+                if (world.score > highScore && !replaying) {
+                    highScore = world.score;
+                }
+                playSound(Sound::EAT);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void handleCollision() {
+        playSound(Sound::COLLISION);
+        for (int i = 0; i < 20; ++i) {
+            Sparkle sp;
+            sp.x = (float)world.snake[0].x + GRID_SIZE / 2;
+            sp.y = (float)world.snake[0].y + GRID_SIZE / 2;
+            sp.life = 1.0f;
+            sparkles.push_back(sp);
+        }
+        // Replays are not new games.
+        if (!replaying) {
+            if (world.score > highScore) {
+                highScore = world.score;
+            }
+            unsettledGames.push_back(finishedGame());
+        }
+        resetGame();
+    }
+
+    // The stats record of the game in the world, ending now.
+    FinishedGame finishedGame() const {
+        GameRecord r;
+        r.seed       = world.seedValue;
+        r.finishedAt = (Sint64)std::time(nullptr);
+        r.score      = (Uint32)world.score;
+        r.length     = (Uint32)world.snake.size();
+        r.ticks      = (Uint32)((world.ticks > gameStartTicks) ? world.ticks - gameStartTicks : 0);
+        r.millis     = SDL_GetTicks() - gameStartTime;
+        r.mode       = (Uint8)config.gameMode;
+        r.pilot      = (Uint8)config.pilot;
+        return FinishedGame{r, gameStartTicks, gameStartTime};
+    }
+
+    // Log the finished games the rewind history no longer holds.
+    void settleGames() {
+        while (unsettledGames.size() > rewindBuffer.parkedGames()) {
+            stats.record(unsettledGames.front().record);
+            unsettledGames.pop_front();
+        }
+    }
+
+    //---------------------------------------------------
+    //             START & RESET GAME
+    //---------------------------------------------------
+    void startGame() {
+        active    = true;
+        paused    = false;
+        replaying = false;
+        rewinding = false;
+        turns.clear();
+        world.numFoodItems = config.numFoodItems;
+        world.numObstacles = config.numObstacles;
+        world.seed(((Uint64)std::time(nullptr) << 32) ^ SDL_GetPerformanceCounter());
+        resetGame();
+        rewindBuffer.setCapacity((size_t)config.rewindTicks);
+        rewindBuffer.start(world);
+        startRecording();
+    }
+
+    // Open a new replay file for the session that just started. Failing to
+    // record is not worth interrupting play for.
+    void startRecording() {
+        if (replayDir.empty()) {
+            return;
+        }
+        std::error_code ec;
+        std::filesystem::create_directories(replayDir, ec);
+
+        char stamp[32];
+        std::time_t now = std::time(nullptr);
+        std::strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+        char seedHex[20];
+        std::snprintf(seedHex, sizeof(seedHex), "%016llx", (unsigned long long)world.seedValue);
+        std::string path = replayDir + "/" + stamp + "-" + seedHex + ".csr";
+
+        ReplayHeader header;
+        header.seed         = world.seedValue;
+        header.cols         = GRID_COLS;
+        header.rows         = GRID_ROWS;
+        header.numFoodItems = (Uint16)config.numFoodItems;
+        header.numObstacles = (Uint16)config.numObstacles;
+        header.gameMode     = (Uint8)config.gameMode;
+        header.snakeSpeed   = (Sint16)config.snakeSpeed;
+        header.keyframeInterval = REPLAY_KEYFRAME_INTERVAL;
+        if (!recorder.open(path, header)) {
+            std::cerr << "Could not record replay to " << path << "\n";
+        }
+    }
+
+    // End the game or playback in progress.
+    void leaveGame() {
+        if (active && !replaying) {
+            unsettledGames.push_back(finishedGame());
+        }
+        for (const FinishedGame& g : unsettledGames) {
+            stats.record(g.record);
+        }
+        unsettledGames.clear();
+        recorder.close();
+        rewindBuffer.stop(world);
+        rewinding = false;
+        replaying = false;
+        active    = false;
+        paused    = false;
+    }
+
+    void resetGame() {
+        rewindBuffer.beforeReset(world);
+        world.reset();
+        gameStartTicks = world.ticks;
+        gameStartTime  = SDL_GetTicks();
+    }
+};
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <vector>
+
+#include "game_world.h"
+
+// A straight stretch of the body: first is the cell nearest the head, and
+// the other cells follow it one grid step apart along dir.
+struct SnakeRun {
+    Point first;
+    Point dir;       // in cells; {0, 0} until the run has a second cell
+    int   length;
+};
+
+//-------------------------------------------------------
+//                      SNAKE RUNS
+//-------------------------------------------------------
+// The snake as straight runs of cells, for drawing one rectangle per run
+// instead of one per cell. A run never crosses a board edge: where the
+// snake wraps, a new run starts.
+//
+// sync() follows the world tick by tick. A normal move adds the new head
+// to the front run (or starts a run where the snake turned) and takes the
+// tail cell off the back one; eating skips the tail. Both are O(1). Any
+// other change (a reset, rewind, a seek) is noticed by checking the head,
+// the cell behind it, the tail and the length, and rebuilds the runs.
+class SnakeRuns {
+public:
+    SnakeRuns()
+        : cells(0)
+    {
+    }
+
+    void clear() {
+        runs.clear();
+        cells = 0;
+    }
+
+    // Bring the runs up to date with snake.
+    void sync(const std::vector<Point>& snake) {
+        const size_t n = snake.size();
+        if (n == 0) {
+            clear();
+            return;
+        }
+        if (cells == n && runs.front().first == snake[0] && tail() == snake.back()) {
+            return;
+        }
+        const bool moved = cells > 0 && n >= 2 && (n == cells || n == cells + 1) &&
+                           runs.front().first == snake[1];
+        if (!moved) {
+            rebuild(snake);
+            return;
+        }
+        pushHead(snake[0]);
+        if (n == cells - 1) {
+            popTail();
+        }
+        if (cells != n || !(tail() == snake.back())) {
+            rebuild(snake);
+        }
+    }
+
+    // One rectangle per run, in screen pixels.
+    void rects(std::vector<SDL_Rect>& out) const {
+        out.clear();
+        for (const SnakeRun& r : runs) {
+            Point last = cellAt(r, r.length - 1);
+            int x = std::min(r.first.x, last.x);
+            int y = std::min(r.first.y, last.y);
+            out.push_back(SDL_Rect{x, y, std::abs(last.x - r.first.x) + GRID_SIZE,
+                                         std::abs(last.y - r.first.y) + GRID_SIZE});
+        }
+    }
+
+    size_t runCount() const  { return runs.size(); }
+    size_t cellCount() const { return cells; }
+
+private:
+    std::deque<SnakeRun> runs;    // head end first
+    size_t               cells;
+
+    static Point cellAt(const SnakeRun& r, int i) {
+        return Point{r.first.x + r.dir.x * GRID_SIZE * i, r.first.y + r.dir.y * GRID_SIZE * i};
+    }
+
+    Point tail() const {
+        const SnakeRun& r = runs.back();
+        return cellAt(r, r.length - 1);
+    }
+
+    // Direction in cells from a to its neighbour b, or {0, 0} if b is not
+    // next to a on screen (across a wrap, or anywhere else).
+    static Point stepBetween(Point a, Point b) {
+        int dx = b.x - a.x;
+        int dy = b.y - a.y;
+        if (dy == 0 && std::abs(dx) == GRID_SIZE) {
+            return Point{dx / GRID_SIZE, 0};
+        }
+        if (dx == 0 && std::abs(dy) == GRID_SIZE) {
+            return Point{0, dy / GRID_SIZE};
+        }
+        return Point{0, 0};
+    }
+
+    void pushHead(Point head) {
+        SnakeRun& front = runs.front();
+        Point dir = stepBetween(head, front.first);
+        bool joins = (dir.x != 0 || dir.y != 0) &&
+                     (front.length == 1 || (front.dir.x == dir.x && front.dir.y == dir.y));
+        if (joins) {
+            front.first = head;
+            front.dir   = dir;
+            front.length++;
+        } else {
+            runs.push_front(SnakeRun{head, Point{0, 0}, 1});
+        }
+        cells++;
+    }
+
+    void popTail() {
+        if (--runs.back().length == 0) {
+            runs.pop_back();
+        }
+        cells--;
+    }
+
+    void rebuild(const std::vector<Point>& snake) {
+        clear();
+        runs.push_back(SnakeRun{snake[0], Point{0, 0}, 1});
+        for (size_t i = 1; i < snake.size(); i++) {
+            SnakeRun& back = runs.back();
+            Point prev = cellAt(back, back.length - 1);
+            Point dir  = stepBetween(prev, snake[i]);
+            bool joins = (dir.x != 0 || dir.y != 0) &&
+                         (back.length == 1 || (back.dir.x == dir.x && back.dir.y == dir.y));
+            if (joins) {
+                back.dir = dir;
+                back.length++;
+            } else {
+                runs.push_back(SnakeRun{snake[i], Point{0, 0}, 1});
+            }
+        }
+        cells = snake.size();
+    }
+};
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+#include "thread_pool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SOFTWARE_RASTER_SSE2 1
+#endif
+
+// The frame is rasterized in square tiles of this many pixels: 130 tiles
+// at 800x600, enough to keep 16 threads busy, and 2040 at 4K.
+const int RASTER_TILE_SIZE = 64;
+
+// One recorded drawing call, with the colour state it was made under.
+struct RasterCommand {
+    enum Kind : Uint8 {
+        CLEAR,
+        RECT,    // x0,y0 inclusive to x1,y1 exclusive, already clipped
+        LINE     // end points, both drawn
+    };
+    Kind   kind;
+    bool   blend;     // alpha below 255 with blending on
+    Uint8  alpha;
+    Uint32 color;     // opaque ARGB
+    int    x0, y0, x1, y1;
+};
+
+//-------------------------------------------------------
+//                  SOFTWARE RASTERIZER
+//-------------------------------------------------------
+// Draws the game's primitives (filled rectangles and one-pixel lines, solid
+// or alpha-blended) into an ARGB8888 buffer in memory, for upload as one
+// texture per frame. Follows SDL's rules: rectangles are clipped to the
+// buffer, lines include both end points, and with blending on a colour of
+// alpha a covers a/255 of what is under it. The buffer is always opaque.
+//
+// Drawing calls are only recorded. render() then bins each command into
+// the tiles its bounds touch, once per frame on the calling thread, and
+// rasterizes the tiles: in order within a tile, clipped to it, and with
+// tiles handed out to the pool's workers through one atomic counter. No
+// two tiles share a pixel and the bins are read-only by then, so the
+// raster phase takes no locks. A line's pixels are the same whichever
+// tile draws them, as each tile steps the line from its own start.
+//
+// Every rectangle row and axis-aligned line is a span, filled four pixels
+// at a time with SSE2 where available. Sloped lines step a 16.16
+// fixed-point position along their major axis, one pixel per step, with no
+// branches but the bounds test.
+class SoftwareRasterizer {
+public:
+    SoftwareRasterizer()
+        : w(0),
+          h(0),
+          tilesX(0),
+          tilesY(0),
+          color(0xFF000000u),
+          alpha(255),
+          blending(false)
+    {
+    }
+
+    void resize(int width, int height) {
+        w = std::max(0, width);
+        h = std::max(0, height);
+        tilesX = (w + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+        tilesY = (h + RASTER_TILE_SIZE - 1) / RASTER_TILE_SIZE;
+        pixels.assign((size_t)w * h, 0xFF000000u);
+        bins.assign((size_t)tilesX * tilesY, std::vector<Uint32>());
+        commands.clear();
+    }
+
+    void setColor(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
+        color = 0xFF000000u | ((Uint32)r << 16) | ((Uint32)g << 8) | b;
+        alpha = a;
+    }
+
+    // SDL_BLENDMODE_BLEND when on, SDL_BLENDMODE_NONE when off.
+    void setBlend(bool on) {
+        blending = on;
+    }
+
+    // Like SDL_RenderClear: the colour is written as is, blend or not.
+    // Nothing recorded before it can show, so that is dropped.
+    void clear() {
+        commands.clear();
+        record(RasterCommand::CLEAR, 0, 0, w, h);
+        commands.back().blend = false;
+    }
+
+    void fillRect(int x, int y, int rw, int rh) {
+        int x0 = std::max(x, 0);
+        int y0 = std::max(y, 0);
+        int x1 = std::min(x + rw, w);
+        int y1 = std::min(y + rh, h);
+        if (x0 < x1 && y0 < y1) {
+            record(RasterCommand::RECT, x0, y0, x1, y1);
+        }
+    }
+
+    void drawLine(int x0, int y0, int x1, int y1) {
+        if (y0 == y1) {
+            fillRect(std::min(x0, x1), y0, std::abs(x1 - x0) + 1, 1);
+        } else if (x0 == x1) {
+            fillRect(x0, std::min(y0, y1), 1, std::abs(y1 - y0) + 1);
+        } else if (std::max(x0, x1) >= 0 && std::min(x0, x1) < w &&
+                   std::max(y0, y1) >= 0 && std::min(y0, y1) < h) {
+            record(RasterCommand::LINE, x0, y0, x1, y1);
+        }
+    }
+
+    // Draw everything recorded since the last render() into the buffer.
+    // With a pool, its workers and the caller share the tiles.
+    void render(ThreadPool* pool = nullptr) {
+        binCommands();
+        const int tiles = tilesX * tilesY;
+        int helpers = pool ? std::min((int)pool->size(), tiles - 1) : 0;
+        if (helpers <= 0) {
+            for (int t = 0; t < tiles; t++) {
+                rasterTile(t);
+            }
+        } else {
+            std::atomic<int> next(0);
+            auto work = [this, &next, tiles] {
+                for (int t = next.fetch_add(1); t < tiles; t = next.fetch_add(1)) {
+                    rasterTile(t);
+                }
+            };
+            for (int i = 0; i < helpers; i++) {
+                pool->submit(work);
+            }
+            work();
+            pool->wait();
+        }
+        commands.clear();
+    }
+
+    const Uint32* data() const { return pixels.data(); }
+    int width() const  { return w; }
+    int height() const { return h; }
+    int pitch() const  { return w * (int)sizeof(Uint32); }
+    size_t recorded() const { return commands.size(); }
+
+private:
+    int                 w;
+    int                 h;
+    int                 tilesX;
+    int                 tilesY;
+    Uint32              color;      // opaque ARGB
+    Uint8               alpha;
+    bool                blending;
+    std::vector<Uint32> pixels;
+    std::vector<RasterCommand>       commands;
+    std::vector<std::vector<Uint32>> bins;    // command indices per tile, in order
+
+    void record(RasterCommand::Kind kind, int x0, int y0, int x1, int y1) {
+        commands.push_back(RasterCommand{kind, blending && alpha < 255, alpha, color,
+                                         x0, y0, x1, y1});
+    }
+
+    void binCommands() {
+        for (auto& bin : bins) {
+            bin.clear();
+        }
+        for (size_t i = 0; i < commands.size(); i++) {
+            const RasterCommand& c = commands[i];
+            // Inclusive pixel bounds, clipped to the buffer.
+            int left, top, right, bottom;
+            if (c.kind == RasterCommand::LINE) {
+                left   = std::max(std::min(c.x0, c.x1), 0);
+                top    = std::max(std::min(c.y0, c.y1), 0);
+                right  = std::min(std::max(c.x0, c.x1), w - 1);
+                bottom = std::min(std::max(c.y0, c.y1), h - 1);
+            } else {
+                left   = c.x0;
+                top    = c.y0;
+                right  = c.x1 - 1;
+                bottom = c.y1 - 1;
+            }
+            if (left > right || top > bottom) {
+                continue;
+            }
+            for (int ty = top / RASTER_TILE_SIZE; ty <= bottom / RASTER_TILE_SIZE; ty++) {
+                for (int tx = left / RASTER_TILE_SIZE; tx <= right / RASTER_TILE_SIZE; tx++) {
+                    bins[(size_t)ty * tilesX + tx].push_back((Uint32)i);
+                }
+            }
+        }
+    }
+
+    void rasterTile(int tile) {
+        const int tx0 = (tile % tilesX) * RASTER_TILE_SIZE;
+        const int ty0 = (tile / tilesX) * RASTER_TILE_SIZE;
+        const int tx1 = std::min(tx0 + RASTER_TILE_SIZE, w);
+        const int ty1 = std::min(ty0 + RASTER_TILE_SIZE, h);
+        for (Uint32 index : bins[tile]) {
+            const RasterCommand& c = commands[index];
+            if (c.kind == RasterCommand::LINE) {
+                rasterLine(c, tx0, ty0, tx1, ty1);
+                continue;
+            }
+            int x0 = std::max(c.x0, tx0);
+            int x1 = std::min(c.x1, tx1);
+            for (int y = std::max(c.y0, ty0); y < std::min(c.y1, ty1); y++) {
+                Uint32* row = &pixels[(size_t)y * w + x0];
+                if (c.blend) {
+                    blendSpan(row, x1 - x0, c.color, c.alpha);
+                } else {
+                    fillSpan(row, x1 - x0, c.color);
+                }
+            }
+        }
+    }
+
+    // The part of a sloped line inside one tile. The major axis moves
+    // exactly one pixel a step, so the steps that land in the tile's range
+    // on that axis are found directly rather than walked to.
+    void rasterLine(const RasterCommand& c, int tx0, int ty0, int tx1, int ty1) {
+        const int dx = c.x1 - c.x0;
+        const int dy = c.y1 - c.y0;
+        const int steps = std::max(std::abs(dx), std::abs(dy));
+        const bool xMajor = std::abs(dx) >= std::abs(dy);
+        const int start = xMajor ? c.x0 : c.y0;
+        const int dir   = (xMajor ? dx : dy) > 0 ? 1 : -1;
+        const int lo    = xMajor ? tx0 : ty0;
+        const int hi    = (xMajor ? tx1 : ty1) - 1;
+        int first = std::max(0, dir > 0 ? lo - start : start - hi);
+        int last  = std::min(steps, dir > 0 ? hi - start : start - lo);
+        if (first > last) {
+            return;
+        }
+        const Sint32 stepX = (Sint32)(((Sint64)dx << 16) / steps);
+        const Sint32 stepY = (Sint32)(((Sint64)dy << 16) / steps);
+        Sint32 fx = c.x0 * 65536 + 0x8000 + first * stepX;
+        Sint32 fy = c.y0 * 65536 + 0x8000 + first * stepY;
+        for (int i = first; i <= last; i++) {
+            int x = fx >> 16;
+            int y = fy >> 16;
+            if (x >= tx0 && x < tx1 && y >= ty0 && y < ty1) {
+                Uint32& p = pixels[(size_t)y * w + x];
+                p = c.blend ? blendPixel(p, c.color, c.alpha) : c.color;
+            }
+            fx += stepX;
+            fy += stepY;
+        }
+    }
+
+    static void fillSpan(Uint32* dst, int n, Uint32 c) {
+        int i = 0;
+#ifdef SOFTWARE_RASTER_SSE2
+        const __m128i v = _mm_set1_epi32((int)c);
+        for (; i + 4 <= n; i += 4) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), v);
+        }
+#endif
+        for (; i < n; i++) {
+            dst[i] = c;
+        }
+    }
+
+    // (x + 1 + (x >> 8)) >> 8 is x / 255, rounded, for x up to 255 * 255.
+    static Uint32 blendPixel(Uint32 dst, Uint32 src, Uint8 a) {
+        const Uint32 inv = 255u - a;
+        Uint32 out = 0xFF000000u;
+        for (int shift = 0; shift < 24; shift += 8) {
+            Uint32 v = ((src >> shift) & 0xFF) * a + ((dst >> shift) & 0xFF) * inv;
+            out |= ((v + 1 + (v >> 8)) >> 8) << shift;
+        }
+        return out;
+    }
+
+    static void blendSpan(Uint32* dst, int n, Uint32 c, Uint8 a) {
+        int i = 0;
+#ifdef SOFTWARE_RASTER_SSE2
+        // Four pixels at a time as 16-bit channels: src*a + dst*(255-a),
+        // then the same divide by 255 as blendPixel().
+        const __m128i zero   = _mm_setzero_si128();
+        const __m128i one    = _mm_set1_epi16(1);
+        const __m128i opaque = _mm_set1_epi32((int)0xFF000000u);
+        const __m128i inv    = _mm_set1_epi16((short)(255 - a));
+        const __m128i src    = _mm_mullo_epi16(_mm_unpacklo_epi8(_mm_set1_epi32((int)c), zero),
+                                               _mm_set1_epi16(a));
+        for (; i + 4 <= n; i += 4) {
+            __m128i d  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+            __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), inv), src);
+            __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), inv), src);
+            lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(lo, one), _mm_srli_epi16(lo, 8)), 8);
+            hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(hi, one), _mm_srli_epi16(hi, 8)), 8);
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i),
+                             _mm_or_si128(_mm_packus_epi16(lo, hi), opaque));
+        }
+#endif
+        for (; i < n; i++) {
+            dst[i] = blendPixel(dst[i], c, a);
+        }
+    }
+};
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+//-------------------------------------------------------
+//              SINGLE-PRODUCER / SINGLE-CONSUMER RING
+//-------------------------------------------------------
+// Fixed-capacity queue between exactly one writing thread and one reading
+// thread. Neither side ever blocks or allocates: push() fails when the
+// ring is full and pop() when it is empty. Capacity must be a power of two.
+//
+// Each index is written by one side only and lives on its own cache line,
+// and each side keeps a private copy of the other's index so it only
+// reloads the shared one when the ring looks full (or empty).
+template <typename T, size_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing()
+        : head(0),
+          tail(0),
+          cachedHead(0),
+          cachedTail(0)
+    {
+    }
+
+    // Producer side.
+    bool push(const T& item) {
+        const size_t t = tail.load(std::memory_order_relaxed);
+        if (t - cachedHead == Capacity) {
+            cachedHead = head.load(std::memory_order_acquire);
+            if (t - cachedHead == Capacity) {
+                return false;
+            }
+        }
+        slots[t & (Capacity - 1)] = item;
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side.
+    bool pop(T& item) {
+        const size_t h = head.load(std::memory_order_relaxed);
+        if (h == cachedTail) {
+            cachedTail = tail.load(std::memory_order_acquire);
+            if (h == cachedTail) {
+                return false;
+            }
+        }
+        item = slots[h & (Capacity - 1)];
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called while the other side is active.
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    alignas(64) std::atomic<size_t> head;    // next slot to read
+    alignas(64) std::atomic<size_t> tail;    // next slot to write
+    alignas(64) size_t cachedHead;           // producer's view of head
+    alignas(64) size_t cachedTail;           // consumer's view of tail
+    alignas(64) T slots[Capacity];
+};
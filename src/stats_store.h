@@ -0,0 +1,355 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "byte_io.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+//-------------------------------------------------------
+//                    STATS LOG FORMAT
+//-------------------------------------------------------
+// games.log is append-only: a 16-byte header ("CSNL", u16 version, u16
+// record size, 8 reserved bytes) followed by fixed-size records, each
+// ending in a CRC-32 of the bytes before it:
+//    0  u64 seed          16  u32 score       28  u32 duration (ms)
+//    8  i64 finished at   20  u32 length      32  u8 mode, u8 pilot, u16 0
+//                         24  u32 ticks       36  u32 crc
+// A crash can only tear the last record, so a bad last record or a short
+// fragment after it is cut off at load. A bad record anywhere else is
+// damage, not a crash: it is skipped and the records after it still count.
+// A file that does not start with this header is moved aside to
+// games.log.bad (or .bad1, .bad2, ...) and a new log started; it is never
+// written over.
+//
+// summary.bin caches the totals over the first `records` records (bad ones
+// included), so start-up only has to read the records appended since. It
+// is replaced atomically (write to a temporary file, then rename) and
+// ignored if its checksum fails or it claims more games than the log
+// holds.
+
+const Uint16 STATS_VERSION         = 1;
+const int    STATS_LOG_HEADER_SIZE = 16;
+const int    STATS_RECORD_SIZE     = 40;
+const int    STATS_SUMMARY_SIZE    = 72;
+
+// Game modes tracked separately in the summary (GameMode values).
+const int    STATS_MODES           = 3;
+
+// Rewrite the summary after this many new games.
+const Uint64 STATS_SUMMARY_EVERY   = 4096;
+
+// One finished game.
+struct GameRecord {
+    Uint64 seed;          // session seed, as in the replay file name
+    Sint64 finishedAt;    // unix time
+    Uint32 score;
+    Uint32 length;        // snake segments at the end
+    Uint32 ticks;
+    Uint32 millis;
+    Uint8  mode;
+    Uint8  pilot;         // 0 = human, otherwise the autopilot in use
+};
+
+struct StatsSummary {
+    Uint64 records;       // log records covered, skipped bad ones included
+    Uint64 games;
+    Uint64 totalScore;
+    Uint64 totalTicks;
+    Uint64 totalMillis;
+    Uint32 bestScore;
+    Uint32 bestLength;
+    Uint32 bestByMode[STATS_MODES];
+
+    StatsSummary()
+        : records(0), games(0), totalScore(0), totalTicks(0), totalMillis(0),
+          bestScore(0), bestLength(0), bestByMode{0, 0, 0}
+    {
+    }
+
+    void add(const GameRecord& r) {
+        records++;
+        games++;
+        totalScore  += r.score;
+        totalTicks  += r.ticks;
+        totalMillis += r.millis;
+        bestScore  = std::max(bestScore, r.score);
+        bestLength = std::max(bestLength, r.length);
+        if (r.mode < STATS_MODES) {
+            bestByMode[r.mode] = std::max(bestByMode[r.mode], r.score);
+        }
+    }
+};
+
+inline void encodeGameRecord(std::vector<Uint8>& out, const GameRecord& r) {
+    size_t start = out.size();
+    putLE(out, r.seed, 8);
+    putLE(out, (Uint64)r.finishedAt, 8);
+    putLE(out, r.score, 4);
+    putLE(out, r.length, 4);
+    putLE(out, r.ticks, 4);
+    putLE(out, r.millis, 4);
+    putLE(out, r.mode, 1);
+    putLE(out, r.pilot, 1);
+    putLE(out, 0, 2);
+    putLE(out, crc32(&out[start], out.size() - start), 4);
+}
+
+inline bool decodeGameRecord(const Uint8* in, GameRecord& r) {
+    if (crc32(in, STATS_RECORD_SIZE - 4) != (Uint32)getLE(in + 36, 4)) {
+        return false;
+    }
+    r.seed       = getLE(in, 8);
+    r.finishedAt = (Sint64)getLE(in + 8, 8);
+    r.score      = (Uint32)getLE(in + 16, 4);
+    r.length     = (Uint32)getLE(in + 20, 4);
+    r.ticks      = (Uint32)getLE(in + 24, 4);
+    r.millis     = (Uint32)getLE(in + 28, 4);
+    r.mode       = in[32];
+    r.pilot      = in[33];
+    return true;
+}
+
+//-------------------------------------------------------
+//                      STATS STORE
+//-------------------------------------------------------
+// Loads the totals at start-up and appends finished games from then on.
+// record() only updates the in-memory summary and queues the write; a
+// single writer thread does all file I/O, in order, so saving never holds
+// up a frame.
+class StatsStore {
+public:
+    StatsStore()
+        : writer(1),
+          opened(false),
+          logFile(nullptr),
+          sinceSummary(0)
+    {
+    }
+
+    ~StatsStore() {
+        close();
+    }
+
+    // Load (or create) the store in dir. Runs on the calling thread.
+    bool open(const std::string& dir) {
+        close();
+        std::error_code ec;
+        std::filesystem::create_directories(dir, ec);
+        logPath     = dir + "/games.log";
+        summaryPath = dir + "/summary.bin";
+
+        StatsSummary loaded;
+        Uint64 covered = readSummary(loaded) ? loaded.records : 0;
+        Uint64 scanned = 0;
+        if (!scanLog(loaded, covered, scanned)) {
+            return false;
+        }
+        current = loaded;
+        written = loaded;
+
+        logFile = std::fopen(logPath.c_str(), "ab");
+        if (!logFile) {
+            return false;
+        }
+        opened       = true;
+        sinceSummary = 0;
+        if (scanned > 0) {
+            // Save the next start-up from reading these again.
+            writeSummary(written);
+        }
+        return true;
+    }
+
+    bool isOpen() const { return opened; }
+
+    // Totals including every game passed to record() so far.
+    const StatsSummary& summary() const { return current; }
+
+    void record(const GameRecord& r) {
+        current.add(r);
+        if (!opened) {
+            return;
+        }
+        writer.submit([this, r] { append(r); });
+    }
+
+    // Block until every queued game is on disk.
+    void flush() {
+        writer.wait();
+    }
+
+    void close() {
+        if (!opened) {
+            return;
+        }
+        writer.submit([this] {
+            std::fclose(logFile);
+            logFile = nullptr;
+            writeSummary(written);
+        });
+        writer.wait();
+        opened = false;
+    }
+
+private:
+    ThreadPool   writer;
+    bool         opened;
+    std::string  logPath;
+    std::string  summaryPath;
+    StatsSummary current;        // main thread's view
+
+    // Only touched by the writer thread once open() has returned.
+    FILE*        logFile;
+    StatsSummary written;
+    Uint64       sinceSummary;
+
+    void append(const GameRecord& r) {
+        std::vector<Uint8> out;
+        encodeGameRecord(out, r);
+        std::fwrite(out.data(), 1, out.size(), logFile);
+        std::fflush(logFile);
+        written.add(r);
+        if (++sinceSummary >= STATS_SUMMARY_EVERY) {
+            writeSummary(written);
+            sinceSummary = 0;
+        }
+    }
+
+    bool readSummary(StatsSummary& s) const {
+        MappedFile file;
+        if (!file.open(summaryPath) || file.size() != (size_t)STATS_SUMMARY_SIZE) {
+            return false;
+        }
+        const Uint8* in = file.data();
+        if (in[0] != 'C' || in[1] != 'S' || in[2] != 'N' || in[3] != 'S' ||
+            getLE(in + 4, 2) != STATS_VERSION ||
+            crc32(in, STATS_SUMMARY_SIZE - 4) != (Uint32)getLE(in + STATS_SUMMARY_SIZE - 4, 4)) {
+            return false;
+        }
+        s.games       = getLE(in + 8, 8);
+        s.totalScore  = getLE(in + 16, 8);
+        s.totalTicks  = getLE(in + 24, 8);
+        s.totalMillis = getLE(in + 32, 8);
+        s.bestScore   = (Uint32)getLE(in + 40, 4);
+        s.bestLength  = (Uint32)getLE(in + 44, 4);
+        for (int m = 0; m < STATS_MODES; m++) {
+            s.bestByMode[m] = (Uint32)getLE(in + 48 + 4 * m, 4);
+        }
+        s.records     = std::max(s.games, getLE(in + 60, 8));
+        return true;
+    }
+
+    void writeSummary(const StatsSummary& s) {
+        std::vector<Uint8> out;
+        out.insert(out.end(), {'C', 'S', 'N', 'S'});
+        putLE(out, STATS_VERSION, 2);
+        putLE(out, 0, 2);
+        putLE(out, s.games, 8);
+        putLE(out, s.totalScore, 8);
+        putLE(out, s.totalTicks, 8);
+        putLE(out, s.totalMillis, 8);
+        putLE(out, s.bestScore, 4);
+        putLE(out, s.bestLength, 4);
+        for (int m = 0; m < STATS_MODES; m++) {
+            putLE(out, s.bestByMode[m], 4);
+        }
+        putLE(out, s.records, 8);
+        out.resize(STATS_SUMMARY_SIZE - 4, 0);
+        putLE(out, crc32(out.data(), out.size()), 4);
+
+        std::string tmp = summaryPath + ".tmp";
+        FILE* f = std::fopen(tmp.c_str(), "wb");
+        if (!f) {
+            return;
+        }
+        bool ok = std::fwrite(out.data(), 1, out.size(), f) == out.size();
+        ok = (std::fclose(f) == 0) && ok;
+        std::error_code ec;
+        if (ok) {
+            std::filesystem::rename(tmp, summaryPath, ec);
+        }
+    }
+
+    // Add the log records past the first `covered` to s, skipping bad
+    // ones. Starts a new log if there is none (moving a foreign file
+    // aside first) and cuts off a torn tail.
+    bool scanLog(StatsSummary& s, Uint64 covered, Uint64& scanned) {
+        scanned = 0;
+        size_t goodSize = 0;
+        size_t fileSize = 0;
+        {
+            MappedFile file;
+            if (file.open(logPath)) {
+                fileSize = file.size();
+            }
+            const Uint8* in = file.data();
+            if (fileSize >= (size_t)STATS_LOG_HEADER_SIZE &&
+                in[0] == 'C' && in[1] == 'S' && in[2] == 'N' && in[3] == 'L' &&
+                getLE(in + 4, 2) == STATS_VERSION &&
+                getLE(in + 6, 2) == (Uint64)STATS_RECORD_SIZE) {
+                Uint64 records = (fileSize - STATS_LOG_HEADER_SIZE) / STATS_RECORD_SIZE;
+                if (covered > records) {
+                    // The summary is from some other log; start over.
+                    s = StatsSummary();
+                    covered = 0;
+                }
+                goodSize = STATS_LOG_HEADER_SIZE + covered * STATS_RECORD_SIZE;
+                GameRecord r;
+                for (Uint64 i = covered; i < records; i++) {
+                    if (decodeGameRecord(in + goodSize, r)) {
+                        s.add(r);
+                    } else if (i + 1 == records) {
+                        break;          // torn last record: cut below
+                    } else {
+                        s.records++;    // damaged: skip, keep the rest
+                    }
+                    goodSize += STATS_RECORD_SIZE;
+                    scanned++;
+                }
+            }
+        }
+
+        std::error_code ec;
+        if (goodSize == 0) {
+            // Missing, empty or foreign: start a new log.
+            if (fileSize > 0 && !moveAside()) {
+                return false;
+            }
+            s = StatsSummary();
+            std::vector<Uint8> header;
+            header.insert(header.end(), {'C', 'S', 'N', 'L'});
+            putLE(header, STATS_VERSION, 2);
+            putLE(header, STATS_RECORD_SIZE, 2);
+            putLE(header, 0, 8);
+            FILE* f = std::fopen(logPath.c_str(), "wb");
+            if (!f) {
+                return false;
+            }
+            std::fwrite(header.data(), 1, header.size(), f);
+            std::fclose(f);
+        } else if (goodSize < fileSize) {
+            std::filesystem::resize_file(logPath, goodSize, ec);
+        }
+        return true;
+    }
+
+    // Rename a log we cannot read to the first free games.log.bad name.
+    bool moveAside() {
+        for (int n = 0; n < 100; n++) {
+            std::string bad = logPath + ".bad" + (n > 0 ? std::to_string(n) : std::string());
+            std::error_code ec;
+            if (std::filesystem::exists(bad, ec)) {
+                continue;
+            }
+            std::filesystem::rename(logPath, bad, ec);
+            return !ec;
+        }
+        return false;
+    }
+};
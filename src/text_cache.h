@@ -0,0 +1,122 @@
+#pragma once
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+
+#include "resource_pack.h"
+
+// A rendered string unused for this many frames is freed. Menu labels are
+// drawn every frame and stay; old score strings fall out.
+const Uint64 TEXT_CACHE_KEEP_FRAMES = 120;
+
+// A string rasterized once and kept as a texture.
+struct CachedText {
+    SDL_Texture* texture;
+    int          w;
+    int          h;
+    Uint64       lastUsed;    // frame number
+};
+
+//-------------------------------------------------------
+//                      TEXT CACHE
+//-------------------------------------------------------
+// Menus redraw the same few labels every frame; rasterizing them with
+// SDL_ttf and uploading a new texture each time cost more than the rest of
+// the frame. Here each (font, colour, text) is rendered once and its
+// texture reused until it goes unused for TEXT_CACHE_KEEP_FRAMES.
+//
+// Also keeps the title fonts open, one per point size, instead of opening
+// the font file for every line drawn.
+class TextCache {
+public:
+    TextCache()
+        : renderer(nullptr),
+          frame(0)
+    {
+    }
+
+    ~TextCache() {
+        clear();
+    }
+
+    // Textures are created on this renderer; clear() before destroying it.
+    void setRenderer(SDL_Renderer* r) {
+        clear();
+        renderer = r;
+    }
+
+    // The texture for text drawn in font, or null if it cannot be rendered.
+    const CachedText* get(TTF_Font* font, const char* text, SDL_Color color) {
+        if (!renderer || !font || !text || !*text) {
+            return nullptr;
+        }
+        key.assign(reinterpret_cast<const char*>(&font), sizeof(font));
+        key.append(reinterpret_cast<const char*>(&color), sizeof(color));
+        key.append(text);
+
+        auto it = entries.find(key);
+        if (it == entries.end()) {
+            SDL_Surface* surface = TTF_RenderText_Solid(font, text, color);
+            if (!surface) {
+                return nullptr;
+            }
+            CachedText t{SDL_CreateTextureFromSurface(renderer, surface), surface->w, surface->h, 0};
+            SDL_FreeSurface(surface);
+            if (!t.texture) {
+                return nullptr;
+            }
+            it = entries.emplace(key, t).first;
+        }
+        it->second.lastUsed = frame;
+        return &it->second;
+    }
+
+    // COMIC.TTF at the given size, opened on first use.
+    TTF_Font* font(int size) {
+        auto it = fonts.find(size);
+        if (it != fonts.end()) {
+            return it->second;
+        }
+        TTF_Font* f = TTF_OpenFontRW(resources().open("COMIC.TTF"), 1, size);
+        if (f) {
+            fonts[size] = f;
+        }
+        return f;
+    }
+
+    // Call once per presented frame to age out unused strings.
+    void endFrame() {
+        frame++;
+        for (auto it = entries.begin(); it != entries.end();) {
+            if (frame - it->second.lastUsed > TEXT_CACHE_KEEP_FRAMES) {
+                SDL_DestroyTexture(it->second.texture);
+                it = entries.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void clear() {
+        for (auto& e : entries) {
+            SDL_DestroyTexture(e.second.texture);
+        }
+        entries.clear();
+        for (auto& f : fonts) {
+            TTF_CloseFont(f.second);
+        }
+        fonts.clear();
+    }
+
+    size_t size() const { return entries.size(); }
+
+private:
+    SDL_Renderer* renderer;
+    Uint64        frame;
+    std::string   key;    // reused to build lookup keys
+    std::unordered_map<std::string, CachedText> entries;
+    std::map<int, TTF_Font*> fonts;
+};
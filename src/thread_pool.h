@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//-------------------------------------------------------
+//                      THREAD POOL
+//-------------------------------------------------------
+// Fixed set of worker threads that run queued jobs in FIFO order. Jobs
+// must not throw. wait() blocks until the queue is empty and every worker
+// is idle; the destructor finishes the queued jobs before joining.
+class ThreadPool {
+public:
+    // threads == 0 picks one worker per hardware thread.
+    explicit ThreadPool(unsigned threads = 0)
+        : active(0),
+          stopping(false)
+    {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (unsigned i = 0; i < threads; i++) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers) {
+            t.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    void submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            jobs.push_back(std::move(job));
+        }
+        wake.notify_one();
+    }
+
+    void wait() {
+        std::unique_lock<std::mutex> lock(mutex);
+        idle.wait(lock, [this] { return jobs.empty() && active == 0; });
+    }
+
+private:
+    std::vector<std::thread>          workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex                        mutex;
+    std::condition_variable           wake;    // a job was queued, or stopping
+    std::condition_variable           idle;    // a worker ran out of work
+    unsigned                          active;
+    bool                              stopping;
+
+    void workerLoop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (jobs.empty()) {
+                return;
+            }
+            std::function<void()> job = std::move(jobs.front());
+            jobs.pop_front();
+            active++;
+            lock.unlock();
+            job();
+            lock.lock();
+            active--;
+            if (jobs.empty() && active == 0) {
+                idle.notify_all();
+            }
+        }
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+
+//-------------------------------------------------------
+//                     TRIPLE BUFFER
+//-------------------------------------------------------
+// Hands the latest value from one writing thread to one reading thread
+// without either ever waiting. The writer fills its back slot and
+// publishes it; the reader takes the most recently published slot as its
+// front. The third slot sits between them, so a slow reader only ever
+// skips values and a slow writer never holds the reader up.
+//
+// Slots are reused in rotation, so a T with vectors keeps their capacity
+// and stops allocating once they have grown.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer()
+        : back(0),
+          middle(1),
+          front(2)
+    {
+    }
+
+    // Writer side: the slot to fill, then publish() it.
+    T& writeSlot() { return slots[back]; }
+
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+    }
+
+    // Reader side: take the latest published value if there is a new one.
+    // Returns false (and keeps the current front) otherwise.
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+        return true;
+    }
+
+    const T& readSlot() const { return slots[front]; }
+
+private:
+    static const unsigned INDEX = 3;
+    static const unsigned FRESH = 4;    // middle holds an unread value
+
+    T slots[3];
+    unsigned              back;      // writer only
+    std::atomic<unsigned> middle;
+    unsigned              front;     // reader only
+};
@@ -0,0 +1,122 @@
+#!/usr/bin/env python3
+"""Pack the game's assets into src/resource_pack.inc.
+
+The output is a C++ byte array holding a resource pack (see
+src/resource_pack.h for the layout), with every file LZ-compressed. When
+the file exists, main.cpp compiles it in and loads assets from memory;
+without it the game falls back to loading files by relative path.
+
+Run from anywhere:  python3 tools/pack_resources.py
+"""
+
+import os
+import struct
+import sys
+import zlib
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Name inside the pack -> source file, relative to the repository root.
+ASSETS = [
+    ("COMIC.TTF", "COMIC.TTF"),
+    ("colision.wav", "src/res/colision.wav"),
+    ("eat.wav", "src/res/eat.wav"),
+]
+
+PACK_VERSION = 1
+MIN_MATCH = 4
+MAX_OFFSET = 0xFFFF
+
+
+def put_length(out, n):
+    while n >= 255:
+        out.append(255)
+        n -= 255
+    out.append(n)
+
+
+def compress(data):
+    """LZ77 in the block format decoded by lzDecompress()."""
+    out = bytearray()
+    table = {}
+    n = len(data)
+    anchor = 0
+    i = 0
+    while i + MIN_MATCH <= n:
+        key = data[i:i + MIN_MATCH]
+        cand = table.get(key)
+        table[key] = i
+        if cand is None or i - cand > MAX_OFFSET:
+            i += 1
+            continue
+        length = MIN_MATCH
+        while i + length < n and data[cand + length] == data[i + length]:
+            length += 1
+
+        literals = i - anchor
+        match = length - MIN_MATCH
+        out.append((min(literals, 15) << 4) | min(match, 15))
+        if literals >= 15:
+            put_length(out, literals - 15)
+        out += data[anchor:i]
+        out += struct.pack("<H", i - cand)
+        if match >= 15:
+            put_length(out, match - 15)
+
+        # Index a few positions inside the match so later data can use it.
+        for j in range(i + 1, min(i + length, n - MIN_MATCH + 1), 2):
+            table[data[j:j + MIN_MATCH]] = j
+        i += length
+        anchor = i
+
+    literals = n - anchor
+    out.append(min(literals, 15) << 4)
+    if literals >= 15:
+        put_length(out, literals - 15)
+    out += data[anchor:]
+    return bytes(out)
+
+
+def build_pack():
+    entries = []
+    for name, path in ASSETS:
+        with open(os.path.join(ROOT, path), "rb") as f:
+            raw = f.read()
+        packed = compress(raw)
+        entries.append((name.encode(), raw, packed))
+
+    # Header, then the directory, then the data.
+    directory = bytearray()
+    dir_size = sum(2 + len(name) + 16 for name, _, _ in entries)
+    offset = 8 + dir_size
+    for name, raw, packed in entries:
+        directory += struct.pack("<H", len(name)) + name
+        directory += struct.pack("<IIII", offset, len(packed), len(raw),
+                                 zlib.crc32(raw) & 0xFFFFFFFF)
+        offset += len(packed)
+
+    blob = bytearray(b"CSNP")
+    blob += struct.pack("<HH", PACK_VERSION, len(entries))
+    blob += directory
+    for _, _, packed in entries:
+        blob += packed
+    return bytes(blob), entries
+
+
+def main():
+    blob, entries = build_pack()
+    target = os.path.join(ROOT, "src", "resource_pack.inc")
+    with open(target, "w", newline="\n") as f:
+        f.write("// Generated by tools/pack_resources.py; do not edit.\n")
+        f.write("static const unsigned char RESOURCE_PACK_DATA[%d] = {\n" % len(blob))
+        for i in range(0, len(blob), 20):
+            f.write("    " + ",".join("0x%02x" % b for b in blob[i:i + 20]) + ",\n")
+        f.write("};\n")
+    for name, raw, packed in entries:
+        print("%-14s %8d -> %8d bytes" % (name.decode(), len(raw), len(packed)))
+    print("wrote %s (%d bytes)" % (os.path.relpath(target, ROOT), len(blob)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())